@@ -0,0 +1,64 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QList>
+
+#include <benchmark/benchmark.h>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/message.h>
+
+#include "fixtures.h"
+#include "nullserver.h"
+
+static void BM_BrowserResponse(benchmark::State &state)
+{
+    // Responses for a number of services are delivered in turn; after the
+    // first round, each one refreshes a service the browser already knows,
+    // which is the steady state on a busy network
+    NullServer server;
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Browser browser(&server, ServiceType, &cache);
+    int events = 0;
+    browser.on<QMdnsEngine::ServiceAdded>([&events](const QMdnsEngine::ServiceAdded &, QMdnsEngine::Browser &) {
+        ++events;
+    });
+    browser.on<QMdnsEngine::ServiceUpdated>([&events](const QMdnsEngine::ServiceUpdated &, QMdnsEngine::Browser &) {
+        ++events;
+    });
+
+    QList<QMdnsEngine::Message> messages;
+    for (int i = 0; i < state.range(0); ++i) {
+        messages.append(serviceResponse(i));
+    }
+
+    int i = 0;
+    for (auto _ : state) {
+        server.deliverMessage(messages.at(i));
+        i = (i + 1) % messages.length();
+    }
+    benchmark::DoNotOptimize(events);
+}
+BENCHMARK(BM_BrowserResponse)->Arg(1)->Arg(64);
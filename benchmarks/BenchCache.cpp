@@ -0,0 +1,89 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+
+#include <benchmark/benchmark.h>
+
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/record.h>
+
+static QMdnsEngine::Record cacheRecord(int index)
+{
+    QMdnsEngine::Record record;
+    record.setName("host-" + QByteArray::number(index) + ".local.");
+    record.setType(QMdnsEngine::A);
+    record.setTtl(3600);
+    record.setAddress(QHostAddress(static_cast<quint32>(0x0a000000 + index)));
+    return record;
+}
+
+// Filling a large cache is expensive, so each size is only populated once
+// and shared by the benchmarks (which leave the number of entries intact)
+static QMdnsEngine::Cache *populatedCache(int size)
+{
+    static QMap<int, QMdnsEngine::Cache*> caches;
+    QMdnsEngine::Cache *cache = caches.value(size);
+    if (!cache) {
+        cache = new QMdnsEngine::Cache;
+        for (int i = 0; i < size; ++i) {
+            cache->addRecord(cacheRecord(i));
+        }
+        caches.insert(size, cache);
+    }
+    return cache;
+}
+
+static void BM_CacheAddRecord(benchmark::State &state)
+{
+    int size = state.range(0);
+    QMdnsEngine::Cache *cache = populatedCache(size);
+
+    // Refresh existing records, as happens for every response received
+    int i = 0;
+    for (auto _ : state) {
+        cache->addRecord(cacheRecord(i));
+        i = (i + 7919) % size;
+    }
+}
+BENCHMARK(BM_CacheAddRecord)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_CacheLookupRecords(benchmark::State &state)
+{
+    int size = state.range(0);
+    QMdnsEngine::Cache *cache = populatedCache(size);
+
+    int i = 0;
+    for (auto _ : state) {
+        QList<QMdnsEngine::Record> records;
+        bool found = cache->lookupRecords(cacheRecord(i).name(), QMdnsEngine::A, records);
+        benchmark::DoNotOptimize(found);
+        i = (i + 7919) % size;
+    }
+}
+BENCHMARK(BM_CacheLookupRecords)->Arg(1000)->Arg(10000)->Arg(100000);
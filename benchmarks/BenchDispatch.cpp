@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <qmdnsengine/message.h>
+
+#include "fixtures.h"
+#include "nullserver.h"
+
+static void BM_DispatchMessage(benchmark::State &state)
+{
+    // Library components sharing a server are each registered as a message
+    // listener, so this measures the fan-out of every received message
+    NullServer server;
+    int calls = 0;
+    for (int i = 0; i < state.range(0); ++i) {
+        server.addMessageListener([&calls](const QMdnsEngine::Message &) {
+            ++calls;
+        });
+    }
+    QMdnsEngine::Message message = serviceResponse(1);
+
+    for (auto _ : state) {
+        server.deliverMessage(message);
+    }
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DispatchMessage)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_EmitterPublish(benchmark::State &state)
+{
+    // The uvw emitter holds a single handler per event, which is the
+    // baseline cost the fan-out above builds on
+    NullServer server;
+    int calls = 0;
+    server.on<QMdnsEngine::MessageReceived>([&calls](const QMdnsEngine::MessageReceived &, QMdnsEngine::AbstractServer &) {
+        ++calls;
+    });
+    QMdnsEngine::Message message = serviceResponse(1);
+
+    for (auto _ : state) {
+        server.deliverMessage(message);
+    }
+    benchmark::DoNotOptimize(calls);
+}
+BENCHMARK(BM_EmitterPublish);
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QByteArray>
+#include <QHostAddress>
+
+#include <benchmark/benchmark.h>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+
+#include "fixtures.h"
+
+static void BM_FromPacket(benchmark::State &state)
+{
+    QByteArray packet;
+    QMdnsEngine::toPacket(serviceResponse(1), packet);
+    QHostAddress address(QStringLiteral("10.0.0.1"));
+
+    for (auto _ : state) {
+        auto message = QMdnsEngine::fromPacket(packet, address, QMdnsEngine::MdnsPort);
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(state.iterations() * packet.length());
+}
+BENCHMARK(BM_FromPacket);
+
+static void BM_ToPacket(benchmark::State &state)
+{
+    QMdnsEngine::Message message = serviceResponse(1);
+
+    for (auto _ : state) {
+        QByteArray packet;
+        QMdnsEngine::toPacket(message, packet);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_ToPacket);
+
+static void BM_ParseNameCompressed(benchmark::State &state)
+{
+    // Build a chain of names where each one is a single label followed by a
+    // pointer to the previous name, so that parsing the last one follows
+    // every pointer in the chain
+    QByteArray packet(12, '\0');
+    quint16 previous = 12;
+    packet.append("\x04test\x05local\x00", 12);
+    for (int i = 1; i < state.range(0); ++i) {
+        quint16 current = packet.length();
+        packet.append("\x01x", 2);
+        packet.append(static_cast<char>(0xc0 | (previous >> 8)));
+        packet.append(static_cast<char>(previous & 0xff));
+        previous = current;
+    }
+
+    for (auto _ : state) {
+        quint16 offset = previous;
+        QByteArray name;
+        bool ok = QMdnsEngine::parseName(packet, offset, name);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(name);
+    }
+}
+BENCHMARK(BM_ParseNameCompressed)->RangeMultiplier(4)->Range(1, 64);
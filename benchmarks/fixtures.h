@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BENCHMARKS_FIXTURES_H
+#define BENCHMARKS_FIXTURES_H
+
+#include <QByteArray>
+#include <QHostAddress>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/record.h>
+
+const QByteArray ServiceType = "_http._tcp.local.";
+
+/**
+ * @brief Build a typical response announcing a service
+ * @param index number used to make the service and host names unique
+ *
+ * The response contains the PTR, SRV and TXT records for the service along
+ * with A and AAAA records for its host, as a responder would send them.
+ */
+inline QMdnsEngine::Message serviceResponse(int index)
+{
+    QByteArray number = QByteArray::number(index);
+    QByteArray serviceName = "Service " + number + "." + ServiceType;
+    QByteArray hostName = "host-" + number + ".local.";
+
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(ServiceType);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTtl(4500);
+    ptrRecord.setTarget(serviceName);
+    message.addRecord(ptrRecord);
+
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(serviceName);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setFlushCache(true);
+    srvRecord.setTtl(120);
+    srvRecord.setTarget(hostName);
+    srvRecord.setPort(8080);
+    message.addRecord(srvRecord);
+
+    QMdnsEngine::Record txtRecord;
+    txtRecord.setName(serviceName);
+    txtRecord.setType(QMdnsEngine::TXT);
+    txtRecord.setFlushCache(true);
+    txtRecord.setTtl(4500);
+    txtRecord.addAttribute("path", "/");
+    txtRecord.addAttribute("version", "1.0");
+    txtRecord.addAttribute("id", number);
+    message.addRecord(txtRecord);
+
+    QMdnsEngine::Record aRecord;
+    aRecord.setName(hostName);
+    aRecord.setType(QMdnsEngine::A);
+    aRecord.setFlushCache(true);
+    aRecord.setTtl(120);
+    aRecord.setAddress(QHostAddress(QHostAddress(QStringLiteral("10.0.0.0")).toIPv4Address() + index));
+    message.addRecord(aRecord);
+
+    QMdnsEngine::Record aaaaRecord;
+    aaaaRecord.setName(hostName);
+    aaaaRecord.setType(QMdnsEngine::AAAA);
+    aaaaRecord.setFlushCache(true);
+    aaaaRecord.setTtl(120);
+    aaaaRecord.setAddress(QHostAddress(QStringLiteral("fe80::1:%1").arg(index & 0xffff, 0, 16)));
+    message.addRecord(aaaaRecord);
+
+    return message;
+}
+
+#endif // BENCHMARKS_FIXTURES_H
@@ -0,0 +1,46 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BENCHMARKS_NULLSERVER_H
+#define BENCHMARKS_NULLSERVER_H
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+/**
+ * @brief Server that discards sent messages and delivers messages on demand
+ */
+class NullServer : public QMdnsEngine::AbstractServer
+{
+public:
+
+    virtual void sendMessage(const QMdnsEngine::Message &) {}
+    virtual void sendMessageToAll(const QMdnsEngine::Message &) {}
+
+    void deliverMessage(const QMdnsEngine::Message &message) {
+        dispatchMessage(message);
+    }
+};
+
+#endif // BENCHMARKS_NULLSERVER_H
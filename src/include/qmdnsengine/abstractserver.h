@@ -25,10 +25,16 @@
 #ifndef QMDNSENGINE_ABSTRACTSERVER_H
 #define QMDNSENGINE_ABSTRACTSERVER_H
 
+#include <functional>
+
+#include <QMap>
 #include <QObject>
 
 #include <uvw/emitter.h>
 
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/statistics.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -55,15 +61,38 @@ struct Error { const QString& message; };
  * receive DNS messages. By having them use this base class, they become far
  * easier to test. Any class derived from this one that implements the pure
  * virtual methods can be used for sending and receiving DNS messages.
+ *
+ * The emitter holds a single listener for each event type, which is left to
+ * the application. Classes in this library that share a server register
+ * through addMessageListener() instead so that they do not replace each
+ * other's listeners.
  */
 class QMDNSENGINE_EXPORT AbstractServer : public uvw::emitter<AbstractServer, MessageReceived, Error> {
 public:
 
+    /**
+     * @brief Callable invoked for each message received
+     */
+    typedef std::function<void(const Message &message)> MessageListener;
+
     /**
      * @brief Abstract constructor
      */
     explicit AbstractServer();
 
+    /**
+     * @brief Register an additional listener for received messages
+     * @param listener callable invoked for each message received
+     * @return identifier that can be passed to removeMessageListener()
+     */
+    int addMessageListener(const MessageListener &listener);
+
+    /**
+     * @brief Remove a listener registered with addMessageListener()
+     * @param id identifier returned when the listener was added
+     */
+    void removeMessageListener(int id);
+
     /**
      * @brief Send a message to its provided destination
      *
@@ -78,6 +107,64 @@ public:
      * The message should be sent over both IPv4 and IPv6 on all interfaces.
      */
     virtual void sendMessageToAll(const Message &message) = 0;
+
+    /**
+     * @brief Retrieve the counters for the server
+     */
+    ServerStatistics statistics() const;
+
+    /**
+     * @brief Retrieve an object that is destroyed along with the server
+     *
+     * Objects that use the server and are not owned by the application can
+     * be made children of it, so that they go away before the server does.
+     * It can also be passed as the context of callbacks (to
+     * QTimer::singleShot(), for example) so that they are dropped once the
+     * server is destroyed.
+     */
+    QObject *context();
+
+protected:
+
+    /**
+     * @brief Deliver a received message to all listeners
+     *
+     * Derived classes invoke this method for each message received. The
+     * MessageReceived event is published after the registered listeners
+     * have been invoked.
+     */
+    void dispatchMessage(const Message &message);
+
+    /**
+     * @brief Publish an Error event
+     * @param message brief description of the error
+     */
+    void reportError(const QString &message);
+
+    /**
+     * @brief Record a packet received on an interface
+     */
+    void recordReceived(const QString &interfaceName, int nBytes);
+
+    /**
+     * @brief Record a packet that could not be parsed
+     */
+    void recordParseError(ParseError error);
+
+    /**
+     * @brief Record a packet sent on an interface
+     */
+    void recordSent(const Message &message, const QString &interfaceName, int nBytes);
+
+private:
+
+    QMap<int, MessageListener> listeners;
+    int nextListenerId;
+    ServerStatistics counters;
+
+    // Declared last so that it is destroyed first, while the listeners can
+    // still be removed by the children being destroyed with it
+    QObject lifetime;
 };
 
 }
@@ -0,0 +1,141 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_BATCHRESOLVER_H
+#define QMDNSENGINE_BATCHRESOLVER_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QSet>
+
+#include <uvw/emitter.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Cache;
+
+class QMDNSENGINE_EXPORT BatchResolverPrivate;
+
+/**
+ * @brief Indicate that a host resolved to an address
+ * @param name name of the host
+ * @param address address of the host
+ *
+ * This event is published once for each address of each host.
+ */
+struct HostResolved {
+    const QByteArray& name;
+    const QHostAddress& address;
+};
+
+/**
+ * @brief Indicate that no address was received for a host in time
+ * @param name name of the host
+ */
+struct HostTimedOut {
+    const QByteArray& name;
+};
+
+/**
+ * @brief %Resolver for a large number of hosts
+ *
+ * Unlike [Resolver](@ref QMdnsEngine::Resolver), which resolves a single
+ * name, this class accepts any number of names at once. The A and AAAA
+ * queries for all of them are packed into as few packets as possible and
+ * results are published as they arrive:
+ *
+ * @code
+ * QMdnsEngine::BatchResolver resolver(&server);
+ * resolver.on<QMdnsEngine::HostResolved>([](const QMdnsEngine::HostResolved &event, const QMdnsEngine::BatchResolver&) {
+ *     qDebug() << event.name << event.address;
+ * });
+ * resolver.resolve({"host1.local.", "host2.local."});
+ * @endcode
+ *
+ * Queries for a host are repeated with increasing intervals until its
+ * timeout elapses. If no address was received by then, the HostTimedOut
+ * event is published for it. When a negative response (an NSEC record)
+ * shows that the host has no A or AAAA records, those types are no longer
+ * queried, and if it has neither, HostTimedOut is published right away.
+ */
+class QMDNSENGINE_EXPORT BatchResolver : public uvw::emitter<BatchResolver, HostResolved, HostTimedOut> {
+public:
+
+    /**
+     * @brief Create a new batch resolver
+     * @param server server to use for receiving and sending mDNS messages
+     * @param cache DNS cache to use or null for none
+     */
+    BatchResolver(AbstractServer *server, Cache *cache = 0);
+
+    /**
+     * @brief Destroy the batch resolver
+     */
+    virtual ~BatchResolver();
+
+    /**
+     * @brief Begin resolving the specified hosts
+     *
+     * Hosts that are already being resolved are ignored.
+     */
+    void resolve(const QSet<QByteArray> &names);
+
+    /**
+     * @brief Stop resolving the specified hosts
+     */
+    void cancel(const QSet<QByteArray> &names);
+
+    /**
+     * @brief Retrieve the number of hosts still being resolved
+     *
+     * Hosts are counted until an address is found for them, they time out
+     * or they are cancelled.
+     */
+    int pendingCount() const;
+
+    /**
+     * @brief Retrieve the time in milliseconds allowed for each host
+     */
+    int timeout() const;
+
+    /**
+     * @brief Set the time in milliseconds allowed for each host
+     *
+     * The default is 3000 ms. The new value only applies to hosts added
+     * after it is set.
+     */
+    void setTimeout(int timeout);
+
+private:
+    friend class BatchResolverPrivate;
+    BatchResolverPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_BATCHRESOLVER_H
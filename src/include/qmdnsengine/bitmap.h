@@ -25,50 +25,55 @@
 #ifndef QMDNSENGINE_BITMAP_H
 #define QMDNSENGINE_BITMAP_H
 
+#include <QByteArray>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
 {
 
-class QMDNSENGINE_EXPORT BitmapPrivate;
-
 /**
- * @brief 256-bit bitmap
+ * @brief Type bitmap for NSEC records
+ *
+ * The bitmap is split into windows of 256 types each. Records in mDNS only
+ * use the first window (window 0), which is stored inline so that creating,
+ * copying and parsing a bitmap does not allocate. Types in other windows
+ * are stored in wire format in a separate buffer that is only allocated
+ * when one of them is set.
  *
- * Bitmaps are used in QMdnsEngine::NSEC records to indicate which records are
- * available. Bitmaps in mDNS records use only the first block (block 0).
+ * @code
+ * QMdnsEngine::Bitmap bitmap;
+ * bitmap.setBit(QMdnsEngine::A);
+ * bitmap.setBit(QMdnsEngine::AAAA);
+ * Q_ASSERT(bitmap.testBit(QMdnsEngine::A));
+ * @endcode
  */
 class QMDNSENGINE_EXPORT Bitmap
 {
 public:
 
     /**
-     * @brief Create an empty bitmap
+     * @brief Maximum number of bytes in a window
      */
-    Bitmap();
+    static constexpr int MaxLength = 32;
 
     /**
-     * @brief Create a copy of an existing bitmap
-     */
-    Bitmap(const Bitmap &other);
-
-    /**
-     * @brief Assignment operator
+     * @brief Create an empty bitmap
      */
-    Bitmap &operator=(const Bitmap &other);
+    Bitmap();
 
     /**
      * @brief Equality operator
      */
-    bool operator==(const Bitmap &other);
+    bool operator==(const Bitmap &other) const;
 
     /**
-     * @brief Destroy the bitmap
+     * @brief Inequality operator
      */
-    virtual ~Bitmap();
+    bool operator!=(const Bitmap &other) const { return !(*this == other); }
 
     /**
-     * @brief Retrieve the length of the block in bytes
+     * @brief Retrieve the length of window 0 in bytes
      *
      * This method indicates how many bytes are pointed to by the data()
      * method.
@@ -76,23 +81,90 @@ public:
     quint8 length() const;
 
     /**
-     * @brief Retrieve a pointer to the underlying data in the bitmap
+     * @brief Retrieve a pointer to the data in window 0
      *
      * Use the length() method to determine how many bytes contain valid data.
      */
     const quint8 *data() const;
 
     /**
-     * @brief Set the data to be stored in the bitmap
+     * @brief Set the data for window 0
      *
-     * The length parameter indicates how many bytes of data are valid. The
-     * actual bytes are copied to the bitmap.
+     * The length parameter indicates how many bytes of data are valid (at
+     * most MaxLength). The actual bytes are copied to the bitmap.
      */
     void setData(quint8 length, const quint8 *data);
 
+    /**
+     * @brief Determine if no types are set
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Determine if the bit for a type is set
+     */
+    bool testBit(quint16 type) const;
+
+    /**
+     * @brief Set the bit for a type
+     */
+    void setBit(quint16 type);
+
+    /**
+     * @brief Retrieve the number of bytes written by toWire()
+     */
+    int wireLength() const;
+
+    /**
+     * @brief Append the windows in wire format to a packet
+     *
+     * Windows without any bytes are omitted, as described in RFC 4034.
+     */
+    void toWire(QByteArray &packet) const;
+
+    /**
+     * @brief Replace the contents with windows in wire format
+     * @param data pointer to the first window
+     * @param length number of bytes in all windows
+     * @return true if the data is valid
+     */
+    bool fromWire(const char *data, int length);
+
+    /**
+     * @brief Retrieve the window that contains a type
+     */
+    static constexpr quint8 windowOf(quint16 type) { return type >> 8; }
+
+    /**
+     * @brief Retrieve the byte in its window that contains a type
+     */
+    static constexpr int byteOf(quint16 type) { return (type & 0xff) >> 3; }
+
+    /**
+     * @brief Retrieve the mask for a type within its byte
+     */
+    static constexpr quint8 maskOf(quint16 type) { return 0x80 >> (type & 0x07); }
+
+    /**
+     * @brief Determine if the bit for a type is set in a single window
+     * @param window bytes in the window
+     * @param length number of bytes in the window
+     * @param type type to test (the window number is ignored)
+     */
+    static constexpr bool testBit(const quint8 *window, int length, quint16 type)
+    {
+        return byteOf(type) < length && (window[byteOf(type)] & maskOf(type));
+    }
+
 private:
 
-    BitmapPrivate *const d;
+    // Window 0, which holds all of the common types, is stored inline;
+    // bytes past firstWindowLength are always zero
+    quint8 firstWindowLength;
+    quint8 firstWindow[MaxLength];
+
+    // Windows 1-255 in wire format, sorted by window number
+    QByteArray otherWindows;
 };
 
 }
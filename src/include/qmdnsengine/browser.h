@@ -26,10 +26,15 @@
 #define QMDNSENGINE_BROWSER_H
 
 #include <QByteArray>
+#include <QList>
+#include <QMap>
 #include <QObject>
 
 #include <uvw/emitter.h>
 
+#include <qmdnsengine/future.h>
+#include <qmdnsengine/service.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -37,7 +42,6 @@ namespace QMdnsEngine
 
 class AbstractServer;
 class Cache;
-class Service;
 
 class QMDNSENGINE_EXPORT BrowserPrivate;
 
@@ -58,6 +62,18 @@ struct ServiceAdded { const Service& service; };
  */
 struct ServiceUpdated { const Service& service; };
 
+/**
+ * @brief Indicate that a service can be connected to
+ *
+ * This signal is emitted once the addresses of the device providing a
+ * service are known, after the service was added. The service includes
+ * its addresses, port and attributes, so no Resolver is needed to connect
+ * to it. If all of the addresses expire, the signal is emitted again once
+ * new ones are received. When changes are batched, the signal follows the
+ * ServicesChanged signal that reports the service.
+ */
+struct ServiceResolved { const Service& service; };
+
 /**
  * @brief Indicate that the specified service was removed
  *
@@ -67,12 +83,67 @@ struct ServiceUpdated { const Service& service; };
  */
 struct ServiceRemoved { const Service& service; };
 
+/**
+ * @brief Indicate that services were added, updated or removed
+ *
+ * This signal replaces ServiceAdded, ServiceUpdated and ServiceRemoved
+ * when batching is enabled with Browser::setBatchInterval(). Each service
+ * appears at most once, in its latest state: a service added and removed
+ * within the same batch is not reported at all.
+ */
+struct ServicesChanged {
+    const QList<Service>& added;
+    const QList<Service>& updated;
+    const QList<Service>& removed;
+};
+
+/**
+ * @brief Services known to a browser at a point in time
+ *
+ * The snapshot is a copy of the browser's state that is not affected by
+ * later changes; taking one is cheap since the services are implicitly
+ * shared with the browser until it changes them.
+ */
+struct QMDNSENGINE_EXPORT BrowserSnapshot
+{
+    /// Version of the state, incremented with each change to a service
+    quint64 version = 0;
+
+    /// Services by FQDN
+    QMap<QByteArray, Service> services;
+};
+
+/**
+ * @brief Changes to the services known to a browser since a version
+ *
+ * Each service appears at most once, in its latest state.
+ */
+struct QMDNSENGINE_EXPORT ServiceChanges
+{
+    /// Current version of the state
+    quint64 version = 0;
+
+    /// Whether the changes are known; if not, a snapshot must be taken
+    bool complete = false;
+
+    /// Services added since the version
+    QList<Service> added;
+
+    /// Services updated since the version
+    QList<Service> updated;
+
+    /// Services removed since the version
+    QList<Service> removed;
+};
+
 /**
  * @brief %Browser for local services
  *
  * This class provides a simple way to discover services on the local network.
  * A cache may be provided in the constructor to store records for future
- * queries.
+ * queries. Otherwise, browsers and resolvers using the same server share a
+ * cache that refreshes each record with a single query, no matter how many
+ * of them are interested in it, and frees records nobody uses anymore.
  *
  * To browse for services of any type:
  *
@@ -80,6 +151,10 @@ struct ServiceRemoved { const Service& service; };
  * QMdnsEngine::Browser browser(&server, QMdnsEngine::MdnsBrowseType);
  * @endcode
  *
+ * In this case, the browser asks for the service types present on the
+ * network and browses for services of each type it finds, so that all of
+ * the services on the network are found in a single sweep.
+ *
  * To browse for services of a specific type:
  *
  * @code
@@ -96,23 +171,94 @@ struct ServiceRemoved { const Service& service; };
  *
  * The serviceUpdated() and serviceRemoved() signals are emitted when services
  * are updated (their properties change) or are removed, respectively.
+ *
+ * The browser queries for the records that are missing once a service is
+ * found: SRV and TXT records for the service and A and AAAA records for its
+ * hostname, combining the queries for all services found at the same time.
+ * The ServiceResolved event is published once the addresses are known.
+ *
+ * Changes can also be received in batches; see setBatchInterval().
  */
-class QMDNSENGINE_EXPORT Browser : public uvw::emitter<Browser, ServiceAdded, ServiceUpdated, ServiceRemoved> {
+class QMDNSENGINE_EXPORT Browser : public uvw::emitter<Browser, ServiceAdded, ServiceUpdated, ServiceResolved, ServiceRemoved, ServicesChanged> {
 public:
 
     /**
      * @brief Create a new browser instance
      * @param server server to use for receiving and sending mDNS messages
      * @param type service type to browse for
-     * @param cache DNS cache to use or null to create one
+     * @param cache DNS cache to use or null to share one with others using the server
      */
     Browser(AbstractServer *server, const QByteArray &type, Cache *cache = 0);
 
+    /**
+     * @brief Destroy the browser
+     */
+    virtual ~Browser();
+
+    /**
+     * @brief Retrieve the services currently known
+     */
+    BrowserSnapshot snapshot() const;
+
+    /**
+     * @brief Retrieve the changes made after a version
+     * @param version version of a snapshot or of previous changes
+     *
+     * This allows a copy of the services to be kept up to date in time
+     * proportional to the number of changes. Only the most recent changes
+     * are kept; if the version is too old, the result is not complete and
+     * a new snapshot must be taken:
+     *
+     * @code
+     * QMdnsEngine::ServiceChanges changes = browser.changesSince(version);
+     * if (!changes.complete) {
+     *     QMdnsEngine::BrowserSnapshot snapshot = browser.snapshot();
+     *     // ...
+     * }
+     * version = changes.version;
+     * @endcode
+     */
+    ServiceChanges changesSince(quint64 version) const;
+
+    /**
+     * @brief Retrieve the interval for batching changes
+     * @return interval in milliseconds or -1 if batching is disabled
+     */
+    int batchInterval() const;
+
+    /**
+     * @brief Set the interval for batching changes
+     * @param interval interval in milliseconds or -1 to disable batching
+     *
+     * When batching is enabled, the changes to services are collected and
+     * published together in a single ServicesChanged event once the
+     * interval has elapsed since the first of them. With an interval of 0,
+     * the changes made during one turn of the event loop are combined (all
+     * of the services in a response, for example). This is much cheaper for
+     * models that update views when many services appear at once.
+     * ServiceResolved is still published right away.
+     */
+    void setBatchInterval(int interval);
+
 private:
     friend class BrowserPrivate;
     BrowserPrivate *const d;
 };
 
+/**
+ * @brief Collect the services of a type present on the network
+ * @param server server to use for receiving and sending mDNS messages
+ * @param type service type to browse for
+ * @param window time in milliseconds to spend browsing
+ * @param cache DNS cache to use or null to share one with others using the server
+ * @return future for the services found
+ *
+ * The future is finished with the services that were known (added and not
+ * removed) once the window has elapsed, or earlier if the server is
+ * destroyed.
+ */
+QMDNSENGINE_EXPORT Future<QList<Service>> browseSnapshot(AbstractServer *server, const QByteArray &type, int window, Cache *cache = 0);
+
 }
 
 #endif // QMDNSENGINE_BROWSER_H
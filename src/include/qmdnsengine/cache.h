@@ -25,29 +25,35 @@
 #ifndef QMDNSENGINE_CACHE_H
 #define QMDNSENGINE_CACHE_H
 
+#include <QByteArray>
 #include <QList>
 #include <QObject>
 
 #include <uvw/emitter.h>
 
+#include <qmdnsengine/statistics.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
 {
 
+class Message;
 class Record;
 
 class QMDNSENGINE_EXPORT CachePrivate;
 
 /**
- * @brief Indicate that a record will expire soon and a new query should be issued
- * @param record reference to the record that will soon expire
+ * @brief Indicate that records will expire soon and new queries should be issued
+ * @param records references to the records that will soon expire
  *
- * This signal is emitted when a record reaches approximately 50%, 85%,
- * 90%, and 95% of its lifetime.
+ * This signal is emitted when records reach approximately 50%, 85%, 90%,
+ * and 95% of their lifetime. All records reaching one of these points at
+ * the same time are reported together so that the queries for them can be
+ * combined.
  */
 struct ShouldQuery {
-    const Record& record;
+    const QList<Record>& records;
 };
 
 /**
@@ -82,25 +88,63 @@ struct RecordExpired {
  * @endcode
  *
  * Alternatively, lookupRecord() can be used to find a single record.
+ *
+ * By default, the cache may only be used from the thread it was created in.
+ * A cache created in Concurrent mode can also be read from other threads
+ * while it is being updated; see ConcurrencyMode for details.
  */
 class QMDNSENGINE_EXPORT Cache : public uvw::emitter<Cache, ShouldQuery, RecordExpired> {
 public:
 
+    /**
+     * @brief Threads from which the cache can be used
+     */
+    enum ConcurrencyMode {
+        /// The cache is only used from the thread it was created in
+        SingleThreaded,
+        /**
+         * Lookups (including lookupKnownAnswers(), hasNegativeEntry(),
+         * saveSnapshot() and statistics()) may be performed from any thread.
+         * Records are stored in buckets guarded by reader-writer locks, so
+         * that an update or expiry only briefly blocks the lookups of names
+         * in the same bucket. All other methods must still be called from
+         * the thread the cache was created in, which is also where the
+         * events are published.
+         */
+        Concurrent
+    };
+
     /**
      * @brief Create an empty cache.
+     * @param mode threads from which the cache can be used
      */
-    Cache();
+    explicit Cache(ConcurrencyMode mode = SingleThreaded);
 
     /**
      * @brief Add a record to the cache
      * @param record add this record to the cache
      *
      * The TTL for the record will be added to the current time to calculate
-     * when the record expires. Existing records of the same name and type
-     * will be replaced, resetting their expiration.
+     * when the record expires. An identical record that already exists is
+     * replaced, resetting its expiration. If the cache-flush bit is set,
+     * other records with the same name and type expire one second later,
+     * except for those received within the last second, which are assumed
+     * to be part of the same set (RFC 6762, section 10.2).
      */
     void addRecord(const Record &record);
 
+    /**
+     * @brief Observe a query sent by a host on the network
+     * @param message message containing the query
+     *
+     * If two or more queries that a cached record answers are observed and
+     * no response refreshes the record within ten seconds of the first
+     * one, the record is expired early and RecordExpired is published
+     * (passive observation of failures, RFC 6762, section 10.5). Records
+     * listed as known answers in a query are not affected by it.
+     */
+    void observeQuery(const Message &message);
+
     /**
      * @brief Retrieve a single record from the cache
      * @param name name of record to retrieve or null for any
@@ -123,6 +167,79 @@ public:
      */
     bool lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const;
 
+    /**
+     * @brief Retrieve records that can be included as known answers
+     * @param name name of records to retrieve
+     * @param type type of records to retrieve or ANY for all types
+     * @param records storage for the records retrieved
+     * @return true if records were retrieved
+     *
+     * Only records with more than half of their TTL remaining are retrieved
+     * (as described in RFC 6762, section 7.1) and their TTL is set to the
+     * time remaining.
+     */
+    bool lookupKnownAnswers(const QByteArray &name, quint16 type, QList<Record> &records) const;
+
+    /**
+     * @brief Determine if a record is known not to exist
+     * @param name name of the record
+     * @param type type of the record
+     * @return true if a cached NSEC record asserts that no such record exists
+     *
+     * NSEC records added to the cache serve as negative entries, as described
+     * in RFC 6762, section 6.1. A cached record of the type takes precedence
+     * over them.
+     */
+    bool hasNegativeEntry(const QByteArray &name, quint16 type) const;
+
+    /**
+     * @brief Remove records from the cache
+     * @param name name of records to remove
+     * @param type type of records to remove or ANY for all types
+     *
+     * Unlike records that expire, the RecordExpired event is not published
+     * for records removed this way.
+     */
+    void removeRecords(const QByteArray &name, quint16 type);
+
+    /**
+     * @brief Save the contents of the cache
+     * @return snapshot that can be passed to loadSnapshot()
+     *
+     * The snapshot uses a compact, versioned binary format: each record is
+     * stored in wire format along with the absolute time at which it
+     * expires, so that it can be restored after a restart. Records longer
+     * than 65535 bytes in wire format are not saved.
+     */
+    QByteArray saveSnapshot() const;
+
+    /**
+     * @brief Restore records from a snapshot
+     * @param snapshot data previously returned by saveSnapshot()
+     * @return true if the snapshot was valid
+     *
+     * Records that expired in the meantime are dropped and the others are
+     * added with the TTL they have remaining. A snapshot that cannot be
+     * parsed leaves the cache untouched. The data is only read during the
+     * call, so a memory-mapped file can be loaded without copying it:
+     *
+     * @code
+     * QFile file("cache.bin");
+     * if (file.open(QIODevice::ReadOnly)) {
+     *     uchar *data = file.map(0, file.size());
+     *     cache.loadSnapshot(QByteArray::fromRawData(
+     *         reinterpret_cast<const char*>(data), file.size()));
+     *     file.unmap(data);
+     * }
+     * @endcode
+     */
+    bool loadSnapshot(const QByteArray &snapshot);
+
+    /**
+     * @brief Retrieve the counters for the cache
+     */
+    CacheStatistics statistics() const;
+
 private:
     friend class CachePrivate;
     CachePrivate *const d;
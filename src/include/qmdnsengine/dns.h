@@ -25,6 +25,9 @@
 #ifndef QMDNSENGINE_DNS_H
 #define QMDNSENGINE_DNS_H
 
+#include <cstdint>
+#include <optional>
+
 #include <QByteArray>
 #include <QHostAddress>
 #include <QMap>
@@ -35,6 +38,7 @@ namespace QMdnsEngine
 {
 
 class Message;
+class Query;
 class Record;
 
 enum {
@@ -54,6 +58,24 @@ enum {
     TXT = 16
 };
 
+/**
+ * @brief Reasons for which a raw DNS packet cannot be parsed
+ */
+enum ParseError {
+    /// The packet was parsed successfully
+    NoParseError = 0,
+    /// The packet is too short to contain a header
+    TruncatedHeader,
+    /// A question could not be parsed
+    InvalidQuery,
+    /// A record in the answer section could not be parsed
+    InvalidAnswer,
+    /// A record in the authority section could not be parsed
+    InvalidAuthority,
+    /// A record in the additional section could not be parsed
+    InvalidAdditional
+};
+
 /**
  * @brief Parse a name from a raw DNS packet
  * @param packet raw DNS packet data
@@ -105,6 +127,15 @@ QMDNSENGINE_EXPORT void writeRecord(QByteArray &packet, quint16 &offset, Record
  */
 QMDNSENGINE_EXPORT std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress& address, std::uint16_t port);
 
+/**
+ * @brief Populate a Message with data from a raw DNS packet
+ * @param packet raw DNS packet data
+ * @param address address the packet was received from
+ * @param port port the packet was received from
+ * @param error set to the reason the packet could not be parsed
+ * @return the message if no errors occurred
+ */
+QMDNSENGINE_EXPORT std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress& address, std::uint16_t port, ParseError &error);
 
 /**
  * @brief Create a raw DNS packet from a Message
@@ -113,6 +144,23 @@ QMDNSENGINE_EXPORT std::optional<Message> fromPacket(const QByteArray &packet, c
  */
 QMDNSENGINE_EXPORT void toPacket(const Message &message, QByteArray &packet);
 
+/**
+ * @brief Estimate the size of a query in a raw DNS packet
+ * @param query query to measure
+ * @return upper bound for the number of bytes written
+ *
+ * Name compression is not taken into account, so the value returned is
+ * never smaller than the number of bytes that toPacket() writes.
+ */
+QMDNSENGINE_EXPORT int querySize(const Query &query);
+
+/**
+ * @brief Estimate the size of a record in a raw DNS packet
+ * @param record record to measure
+ * @return upper bound for the number of bytes written
+ */
+QMDNSENGINE_EXPORT int recordSize(const Record &record);
+
 /**
  * @brief Retrieve the string representation of a DNS type
  * @param type integer type
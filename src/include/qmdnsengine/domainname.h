@@ -0,0 +1,195 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_DOMAINNAME_H
+#define QMDNSENGINE_DOMAINNAME_H
+
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#include <QHashFunctions>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+struct DomainNameData;
+
+/**
+ * @brief DNS name stored as wire-format labels
+ *
+ * The name is split into labels once when it is created and a
+ * case-insensitive hash is computed for every suffix of the name. This
+ * makes comparisons, suffix checks and parent() cheap: none of them
+ * allocate and most mismatches are detected by comparing hashes.
+ *
+ * @code
+ * QMdnsEngine::DomainName type("_http._tcp.local.");
+ * QMdnsEngine::DomainName service("My Service._HTTP._tcp.local.");
+ * Q_ASSERT(service.parent() == type);
+ * Q_ASSERT(service.isSubdomainOf(type));
+ * @endcode
+ *
+ * Names are compared as described in RFC 4343: ASCII letters are compared
+ * without regard to case and all other bytes must match exactly.
+ */
+class QMDNSENGINE_EXPORT DomainName
+{
+public:
+
+    /**
+     * @brief Create a null name
+     */
+    DomainName();
+
+    /**
+     * @brief Create a name from its text form
+     * @param name labels separated by "." with an optional trailing "."
+     *
+     * An empty name or "." creates the root name. If the name contains an
+     * empty label, a label longer than 63 bytes, or is longer than 255 bytes
+     * in wire format, a null name is created.
+     */
+    explicit DomainName(const QByteArray &name);
+
+    /**
+     * @brief Create a copy of an existing name
+     */
+    DomainName(const DomainName &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    DomainName &operator=(const DomainName &other);
+
+    /**
+     * @brief Destroy the name
+     */
+    ~DomainName();
+
+    /**
+     * @brief Create a name from uncompressed wire-format labels
+     * @param wire length-prefixed labels ending with a zero-length label
+     * @return the name or a null name if the data is invalid
+     */
+    static DomainName fromWire(const QByteArray &wire);
+
+    /**
+     * @brief Determine if this is a null name
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Determine if this is the root name
+     */
+    bool isRoot() const;
+
+    /**
+     * @brief Retrieve the number of labels (zero for the root name)
+     */
+    int labelCount() const;
+
+    /**
+     * @brief Retrieve a label
+     * @param index index of the label, starting with the leftmost one
+     */
+    QByteArray label(int index) const;
+
+    /**
+     * @brief Retrieve the name one level up
+     * @return the parent or a null name for the root name
+     *
+     * The parent shares storage with this name.
+     */
+    DomainName parent() const;
+
+    /**
+     * @brief Determine if this name is below another one
+     * @param other potential ancestor
+     * @return true if other is a proper suffix of this name
+     */
+    bool isSubdomainOf(const DomainName &other) const;
+
+    /**
+     * @brief Compare with a name in text form
+     * @param name labels separated by "." with an optional trailing "."
+     * @return true if the names are equal
+     */
+    bool matches(const QByteArray &name) const;
+
+    /**
+     * @brief Determine if a name in text form is below this one
+     * @param name labels separated by "." with an optional trailing "."
+     * @return true if this name is a proper suffix of the name
+     *
+     * This is equivalent to DomainName(name).isSubdomainOf(*this) but does
+     * not allocate.
+     */
+    bool isParentOf(const QByteArray &name) const;
+
+    /**
+     * @brief Retrieve the text form of the name (with a trailing ".")
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * @brief Retrieve the wire format of the name (without compression)
+     */
+    QByteArray toWire() const;
+
+    /**
+     * @brief Retrieve the case-insensitive hash of the name
+     */
+    uint hash() const;
+
+    /**
+     * @brief Equality operator
+     */
+    bool operator==(const DomainName &other) const;
+
+    /**
+     * @brief Inequality operator
+     */
+    bool operator!=(const DomainName &other) const { return !(*this == other); }
+
+    /**
+     * @brief Hash function for use in QHash and QSet
+     */
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    friend size_t qHash(const DomainName &name, size_t seed = 0) noexcept { return ::qHash(name.hash(), seed); }
+#else
+    friend uint qHash(const DomainName &name, uint seed = 0) noexcept { return ::qHash(name.hash(), seed); }
+#endif
+
+private:
+
+    bool compareText(const char *name, int length) const;
+
+    QExplicitlySharedDataPointer<DomainNameData> d;
+    int first;
+};
+
+}
+
+#endif // QMDNSENGINE_DOMAINNAME_H
@@ -0,0 +1,218 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_FUTURE_H
+#define QMDNSENGINE_FUTURE_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#  if __has_include(<coroutine>)
+#    include <coroutine>
+#    define QMDNSENGINE_HAS_COROUTINES
+#  endif
+#endif
+
+namespace QMdnsEngine
+{
+
+template<typename T>
+class Promise;
+
+/**
+ * @brief Result of an operation that completes later
+ *
+ * Instances are returned by functions such as
+ * [resolveOnce()](@ref QMdnsEngine::resolveOnce) and
+ * [browseSnapshot()](@ref QMdnsEngine::browseSnapshot). The operation runs on
+ * the event loop of the calling thread - no additional threads are used - so
+ * the result must never be waited for by blocking that thread.
+ *
+ * A callback can be provided that is invoked once the result is available:
+ *
+ * @code
+ * QMdnsEngine::resolveOnce(&server, "myhost.local.", 1000).then([](const QHostAddress &address) {
+ *     qDebug() << "Address:" << address;
+ * });
+ * @endcode
+ *
+ * When compiling with C++20, instances can also be awaited from within a
+ * coroutine (using any coroutine task type that resumes on the same thread):
+ *
+ * @code
+ * QHostAddress address = co_await QMdnsEngine::resolveOnce(&server, "myhost.local.", 1000);
+ * @endcode
+ */
+template<typename T>
+class Future
+{
+public:
+
+    /**
+     * @brief Determine if the result is available
+     */
+    bool isFinished() const
+    {
+        return d->finished;
+    }
+
+    /**
+     * @brief Retrieve the result
+     *
+     * This value is only valid when isFinished() returns true.
+     */
+    T result() const
+    {
+        return d->result;
+    }
+
+    /**
+     * @brief Invoke a callback once the result is available
+     *
+     * If the result is already available, the callback is invoked
+     * immediately.
+     */
+    void then(const std::function<void(const T &result)> &callback) const
+    {
+        if (d->finished) {
+            callback(d->result);
+        } else {
+            d->callbacks.push_back(callback);
+        }
+    }
+
+#ifdef QMDNSENGINE_HAS_COROUTINES
+    /**
+     * @brief Suspend the awaiting coroutine until the result is available
+     */
+    auto operator co_await() const
+    {
+        struct Awaiter
+        {
+            std::shared_ptr<typename Promise<T>::State> d;
+
+            bool await_ready() const noexcept
+            {
+                return d->finished;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const
+            {
+                d->callbacks.push_back([handle](const T &) {
+                    handle.resume();
+                });
+            }
+
+            T await_resume() const
+            {
+                return d->result;
+            }
+        };
+        return Awaiter{d};
+    }
+#endif
+
+private:
+
+    friend class Promise<T>;
+
+    explicit Future(const std::shared_ptr<typename Promise<T>::State> &state)
+        : d(state)
+    {
+    }
+
+    std::shared_ptr<typename Promise<T>::State> d;
+};
+
+/**
+ * @brief Producer side of a Future
+ *
+ * Copies of a promise share the same state. Only the first call to finish()
+ * has any effect.
+ */
+template<typename T>
+class Promise
+{
+public:
+
+    /**
+     * @brief Create a new promise
+     */
+    Promise()
+        : d(std::make_shared<State>())
+    {
+    }
+
+    /**
+     * @brief Retrieve the future for this promise
+     */
+    Future<T> future() const
+    {
+        return Future<T>(d);
+    }
+
+    /**
+     * @brief Determine if a result was already provided
+     */
+    bool isFinished() const
+    {
+        return d->finished;
+    }
+
+    /**
+     * @brief Provide the result and invoke any waiting callbacks
+     */
+    void finish(const T &result) const
+    {
+        if (d->finished) {
+            return;
+        }
+        d->finished = true;
+        d->result = result;
+        auto callbacks = std::move(d->callbacks);
+        d->callbacks.clear();
+        for (const auto &callback : callbacks) {
+            callback(d->result);
+        }
+    }
+
+private:
+
+    friend class Future<T>;
+
+    struct State
+    {
+        bool finished = false;
+        T result = T();
+        std::vector<std::function<void(const T &)>> callbacks;
+    };
+
+    std::shared_ptr<State> d;
+};
+
+}
+
+#endif // QMDNSENGINE_FUTURE_H
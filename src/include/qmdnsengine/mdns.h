@@ -48,6 +48,14 @@ QMDNSENGINE_EXPORT extern const QHostAddress MdnsIpv4Address;
  */
 QMDNSENGINE_EXPORT extern const QHostAddress MdnsIpv6Address;
 
+/**
+ * @brief Largest mDNS payload that fits in a single Ethernet frame
+ *
+ * Messages composed from many queries or records are split so that each
+ * packet stays within this size.
+ */
+QMDNSENGINE_EXPORT extern const int MdnsMaxPacketSize;
+
 /**
  * @brief Service type for browsing service types
  */
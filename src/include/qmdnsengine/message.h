@@ -171,6 +171,20 @@ public:
      */
     void addRecord(const Record &record);
 
+    /**
+     * @brief Retrieve a list of records in the authority section
+     *
+     * Probe queries use the authority section to describe the records that
+     * the sender intends to claim, which is needed for breaking ties between
+     * simultaneous probes.
+     */
+    std::list<Record> authorityRecords() const;
+
+    /**
+     * @brief Add a record to the authority section of the message
+     */
+    void addAuthorityRecord(const Record &record);
+
     /**
      * @brief Reply to another message
      *
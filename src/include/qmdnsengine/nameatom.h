@@ -0,0 +1,182 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_NAMEATOM_H
+#define QMDNSENGINE_NAMEATOM_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHashFunctions>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+/**
+ * @brief Entry in the table of interned names (implementation detail)
+ *
+ * There is an entry for each spelling of a name. Entries for spellings
+ * with uppercase letters hold a reference to the entry for the lowercase
+ * spelling, which identifies the name. The hash of the lowercase spelling
+ * is computed once when the name is interned.
+ */
+struct NameAtomData
+{
+    NameAtomData(const QByteArray &name) : ref(1), name(name), canonical(nullptr), hash(0) {}
+
+    QAtomicInt ref;
+    QByteArray name;
+    NameAtomData *canonical;
+    size_t hash;
+};
+
+/**
+ * @brief Shared handle for an interned DNS name
+ *
+ * Names such as service types and hostnames recur in many records, queries
+ * and cache entries. Interning a name stores it once in a global,
+ * thread-safe table and returns a reference-counted handle to it. Since
+ * DNS names are case-insensitive, atoms for names that differ only in the
+ * case of ASCII letters compare equal, while each one keeps its own
+ * spelling. Comparing atoms only compares pointers:
+ *
+ * @code
+ * QMdnsEngine::NameAtom a("_http._tcp.local.");
+ * QMdnsEngine::NameAtom b("_HTTP._tcp.local.");
+ * Q_ASSERT(a == b);
+ * @endcode
+ *
+ * An entry is removed from the table once the last handle to it is
+ * destroyed.
+ */
+class QMDNSENGINE_EXPORT NameAtom
+{
+public:
+
+    /**
+     * @brief Create a null atom
+     */
+    NameAtom();
+
+    /**
+     * @brief Intern a name
+     * @param name name to intern (a null name creates a null atom)
+     */
+    explicit NameAtom(const QByteArray &name);
+
+    /**
+     * @brief Create a copy of an existing atom
+     */
+    NameAtom(const NameAtom &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    NameAtom &operator=(const NameAtom &other);
+
+    /**
+     * @brief Destroy the handle
+     */
+    ~NameAtom();
+
+    /**
+     * @brief Equality operator
+     */
+    bool operator==(const NameAtom &other) const { return canonical() == other.canonical(); }
+
+    /**
+     * @brief Inequality operator
+     */
+    bool operator!=(const NameAtom &other) const { return canonical() != other.canonical(); }
+
+    /**
+     * @brief Determine if this is a null atom
+     */
+    bool isNull() const { return !d; }
+
+    /**
+     * @brief Retrieve a hash of the canonical name
+     *
+     * The hash is computed once when the name is interned and does not
+     * depend on the address of the entry, which makes it suitable for
+     * distributing atoms between buckets.
+     */
+    size_t hash() const { return d ? d->canonical->hash : 0; }
+
+    /**
+     * @brief Retrieve the name, as spelled when it was interned
+     */
+    QByteArray name() const;
+
+    /**
+     * @brief Retrieve the lowercase form used to identify the name
+     */
+    QByteArray canonicalName() const;
+
+    /**
+     * @brief Find the atom for a name without interning it
+     * @param name name to look for
+     * @return the atom or a null atom if the name is not interned
+     *
+     * If the name is only interned with a different spelling, an atom for
+     * the lowercase spelling is returned.
+     *
+     * A name that is not interned cannot be in use by any record, which
+     * makes this useful for lookups.
+     */
+    static NameAtom find(const QByteArray &name);
+
+    /**
+     * @brief Retrieve the number of spellings of names currently interned
+     */
+    static int tableSize();
+
+    /**
+     * @brief Convert ASCII letters in a name to lowercase
+     *
+     * Unlike QByteArray::toLower(), bytes outside of the ASCII range are
+     * left untouched, as required for comparing DNS names.
+     */
+    static QByteArray canonicalize(const QByteArray &name);
+
+    /**
+     * @brief Hash function for use in QHash and QSet
+     */
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    friend size_t qHash(const NameAtom &atom, size_t seed = 0) noexcept { return ::qHash(atom.hash(), seed); }
+#else
+    friend uint qHash(const NameAtom &atom, uint seed = 0) noexcept { return ::qHash(atom.hash(), seed); }
+#endif
+
+private:
+
+    const NameAtomData *canonical() const { return d ? d->canonical : nullptr; }
+
+    NameAtomData *d;
+};
+
+}
+
+#endif // QMDNSENGINE_NAMEATOM_H
@@ -44,6 +44,13 @@ class QMDNSENGINE_EXPORT ProberPrivate;
  * must be confirmed. This class takes care of probing for existing records
  * that match and adjusts the record's name until a unique one is found.
  *
+ * Probing follows RFC 6762: three probes are sent 250 ms apart with the
+ * proposed record in the authority section and the name is confirmed 250 ms
+ * after the last probe. Probers sharing a server have their probes combined
+ * into the same packets, so many names can be confirmed at once in well
+ * under a second. Simultaneous probes from other hosts for the same name are
+ * resolved by comparing the proposed records.
+ *
  * For example, to probe for a SRV record:
  *
  * @code
@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_PROMETHEUSEXPORTER_H
+#define QMDNSENGINE_PROMETHEUSEXPORTER_H
+
+#include <QHostAddress>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Cache;
+
+class QMDNSENGINE_EXPORT PrometheusExporterPrivate;
+
+/**
+ * @brief Serve statistics to Prometheus over HTTP
+ *
+ * Each request received is answered with a snapshot of the statistics for
+ * the server and cache in the Prometheus text exposition format. By default
+ * the exporter only accepts connections from the local host:
+ *
+ * @code
+ * QMdnsEngine::PrometheusExporter exporter(&server, &cache);
+ * exporter.listen(QHostAddress::LocalHost, 9353);
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT PrometheusExporter
+{
+public:
+
+    /**
+     * @brief Create a new exporter
+     * @param server server to collect statistics from
+     * @param cache cache to collect statistics from or 0 for none
+     */
+    PrometheusExporter(AbstractServer *server, Cache *cache = 0);
+
+    /**
+     * @brief Destroy the exporter
+     */
+    ~PrometheusExporter();
+
+    /**
+     * @brief Start accepting connections
+     * @param address address to listen on
+     * @param port port to listen on or 0 to pick one
+     * @return true if the exporter is listening
+     */
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 0);
+
+    /**
+     * @brief Retrieve the port the exporter is listening on
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Stop accepting connections
+     */
+    void close();
+
+private:
+
+    PrometheusExporterPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_PROMETHEUSEXPORTER_H
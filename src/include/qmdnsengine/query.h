@@ -27,6 +27,8 @@
 
 #include <QByteArray>
 
+#include <qmdnsengine/nameatom.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -82,6 +84,11 @@ public:
      */
     void setName(const QByteArray &name);
 
+    /**
+     * @brief Retrieve the interned name being queried
+     */
+    const NameAtom &nameAtom() const;
+
     /**
      * @brief Retrieve the type of record being queried
      */
@@ -30,6 +30,7 @@
 #include <QMap>
 
 #include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/nameatom.h>
 
 #include "qmdnsengine_export.h"
 
@@ -100,6 +101,14 @@ public:
      */
     void setName(const QByteArray &name);
 
+    /**
+     * @brief Retrieve the interned name of the record
+     *
+     * Comparing atoms is cheaper than comparing names and ignores case, as
+     * DNS requires.
+     */
+    const NameAtom &nameAtom() const;
+
     /**
      * @brief Retrieve the type of the record
      */
@@ -217,7 +226,10 @@ public:
     /**
      * @brief Retrieve attributes for the record
      *
-     * This field is used by QMdnsEngine::TXT records.
+     * This field is used by QMdnsEngine::TXT records. The TXT data is parsed
+     * the first time attributes are retrieved. If a key appears more than
+     * once, only the first occurrence is used (as described in RFC 6763,
+     * section 6.4).
      */
     QMap<QByteArray, QByteArray> attributes() const;
 
@@ -228,9 +240,27 @@ public:
 
     /**
      * @brief Add an attribute to the record
+     *
+     * The attribute is appended to the TXT data. If the key is already
+     * present, its value is replaced and the data is rewritten as if
+     * setAttributes() had been called.
      */
     void addAttribute(const QByteArray &key, const QByteArray &value);
 
+    /**
+     * @brief Retrieve the TXT data for the record in wire format
+     *
+     * The data consists of length-prefixed strings and is empty if the
+     * record has no attributes. Comparing the data of two records is much
+     * cheaper than comparing their attributes.
+     */
+    QByteArray txtData() const;
+
+    /**
+     * @brief Set the TXT data for the record in wire format
+     */
+    void setTxtData(const QByteArray &txtData);
+
     /**
      * @brief Retrieve the bitmap for the record
      *
@@ -28,6 +28,8 @@
 #include <QHostAddress>
 #include <QObject>
 
+#include <qmdnsengine/future.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -63,6 +65,9 @@ public:
 
     /**
      * @brief Create a new resolver
+     *
+     * If no cache is provided, the resolver uses a cache shared with the
+     * other browsers and resolvers using the same server.
      */
     Resolver(AbstractServer *server, const QByteArray &name, Cache *cache = 0, QObject *parent = 0);
 
@@ -78,11 +83,34 @@ Q_SIGNALS:
      */
     void resolved(const QHostAddress &address);
 
+    /**
+     * @brief Indicate that the host has no addresses
+     *
+     * This signal is emitted when a negative response shows that the host
+     * has neither A nor AAAA records and no address was received for it.
+     * No further queries are sent in that case.
+     */
+    void failed();
+
 private:
 
     ResolverPrivate *const d;
 };
 
+/**
+ * @brief Resolve a host to a single address
+ * @param server server to use for receiving and sending mDNS messages
+ * @param name name of the host to resolve
+ * @param timeout time in milliseconds to wait for an address
+ * @param cache DNS cache to use or null for none
+ * @return future for the first address received
+ *
+ * The future is finished with the first address received for the host or
+ * with a null address if none was received before the timeout elapsed or
+ * the server was destroyed.
+ */
+QMDNSENGINE_EXPORT Future<QHostAddress> resolveOnce(AbstractServer *server, const QByteArray &name, int timeout, Cache *cache = 0);
+
 }
 
 #endif // QMDNSENGINE_RESOLVER_H
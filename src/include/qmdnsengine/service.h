@@ -117,6 +117,19 @@ public:
      */
     void setHostname(const QByteArray &hostname);
 
+    /**
+     * @brief Retrieve the addresses of the device providing the service
+     *
+     * Only services provided by [Browser](@ref QMdnsEngine::Browser) have
+     * addresses, once the address records for their hostname are received.
+     */
+    QList<QHostAddress> addresses() const;
+
+    /**
+     * @brief Set the addresses of the device providing the service
+     */
+    void setAddresses(const QList<QHostAddress> &addresses);
+
     /**
      * @brief Retrieve the service port
      */
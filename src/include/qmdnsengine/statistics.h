@@ -0,0 +1,180 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_STATISTICS_H
+#define QMDNSENGINE_STATISTICS_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+#include <qmdnsengine/dns.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Cache;
+
+/**
+ * @brief Packet and byte counters for one direction of traffic
+ */
+struct QMDNSENGINE_EXPORT TrafficStatistics
+{
+    TrafficStatistics();
+
+    /// Number of packets received
+    quint64 packetsReceived;
+
+    /// Number of bytes received
+    quint64 bytesReceived;
+
+    /// Number of packets sent
+    quint64 packetsSent;
+
+    /// Number of bytes sent
+    quint64 bytesSent;
+};
+
+/**
+ * @brief Counters maintained by a server
+ *
+ * Traffic is recorded by servers that send and receive packets (such as
+ * [Server](@ref QMdnsEngine::Server)), keyed by the name of the interface.
+ * Packets sent leave on whichever interface the operating system selects,
+ * so Server records them under "ipv4" or "ipv6" instead. Packets that
+ * could not be sent are not recorded.
+ */
+struct QMDNSENGINE_EXPORT ServerStatistics
+{
+    ServerStatistics();
+
+    /// Traffic for all interfaces combined
+    TrafficStatistics total;
+
+    /// Traffic for each interface
+    QMap<QString, TrafficStatistics> interfaces;
+
+    /// Number of packets that could not be parsed for each reason
+    QMap<ParseError, quint64> parseErrors;
+
+    /// Number of queries received
+    quint64 queriesReceived;
+
+    /// Number of responses received
+    quint64 responsesReceived;
+
+    /// Number of packets containing queries sent
+    quint64 queriesSent;
+
+    /// Number of packets containing responses sent
+    quint64 responsesSent;
+
+    /// Number of MessageReceived events dispatched
+    quint64 messageEvents;
+
+    /// Number of Error events dispatched
+    quint64 errorEvents;
+
+    /// Number of calls made to message listeners
+    quint64 listenerCalls;
+};
+
+/**
+ * @brief Counters maintained by a cache
+ */
+struct QMDNSENGINE_EXPORT CacheStatistics
+{
+    CacheStatistics();
+
+    /// Number of records currently in the cache
+    quint64 size;
+
+    /// Number of lookups that found at least one record
+    quint64 hits;
+
+    /// Number of lookups that found no records
+    quint64 misses;
+
+    /// Number of records added or refreshed
+    quint64 insertions;
+
+    /// Number of records removed because their TTL expired or was set to 0
+    quint64 expirations;
+};
+
+/**
+ * @brief Point-in-time copy of the statistics for a server and cache
+ *
+ * Taking a snapshot only copies the counters, so it is cheap enough to do
+ * frequently. Rates are computed from two snapshots:
+ *
+ * @code
+ * StatisticsSnapshot previous = StatisticsSnapshot::take(&server, &cache);
+ * // ...
+ * StatisticsSnapshot current = StatisticsSnapshot::take(&server, &cache);
+ * double queriesPerSecond = current.queryRate(previous);
+ * @endcode
+ */
+struct QMDNSENGINE_EXPORT StatisticsSnapshot
+{
+    StatisticsSnapshot();
+
+    /**
+     * @brief Take a snapshot of the statistics
+     * @param server server to collect statistics from
+     * @param cache cache to collect statistics from or 0 for none
+     */
+    static StatisticsSnapshot take(const AbstractServer *server, const Cache *cache = 0);
+
+    /**
+     * @brief Number of queries received per second since an earlier snapshot
+     */
+    double queryRate(const StatisticsSnapshot &previous) const;
+
+    /**
+     * @brief Number of responses received per second since an earlier snapshot
+     */
+    double responseRate(const StatisticsSnapshot &previous) const;
+
+    /**
+     * @brief Format the statistics in the Prometheus text exposition format
+     */
+    QByteArray toPrometheus() const;
+
+    /// Monotonic time the snapshot was taken in milliseconds
+    qint64 timestamp;
+
+    /// Statistics for the server
+    ServerStatistics server;
+
+    /// Statistics for the cache (all zero if none was provided)
+    CacheStatistics cache;
+};
+
+}
+
+#endif // QMDNSENGINE_STATISTICS_H
@@ -0,0 +1,197 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_TRACING_H
+#define QMDNSENGINE_TRACING_H
+
+#include <QString>
+#include <QVector>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+/**
+ * @brief Points in the library where time is measured
+ */
+enum TracePoint {
+    /// Parsing a raw packet with fromPacket()
+    TraceDecode = 0,
+    /// Delivering a received message to all listeners
+    TraceDispatch,
+    /// Invoking a single message listener
+    TraceListener,
+    /// Adding a record to a cache
+    TraceCacheUpdate,
+    /// Creating a raw packet with toPacket()
+    TraceEncode,
+    /// Encoding and sending a message
+    TraceSend,
+    /// Determining the records that answer a query and sending them
+    TraceRespond,
+    /// Number of trace points
+    TracePointCount
+};
+
+/**
+ * @brief Histogram of latencies with bounded relative error
+ *
+ * Values are counted in buckets whose width grows with their magnitude
+ * (in the manner of an HDR histogram), so that any value from nanoseconds
+ * to hours is stored with a relative error of about 6% in constant space.
+ */
+class QMDNSENGINE_EXPORT LatencyHistogram
+{
+public:
+
+    /**
+     * @brief Create an empty histogram
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Count a value
+     * @param value latency in nanoseconds
+     */
+    void record(qint64 value);
+
+    /**
+     * @brief Add the values counted in another histogram
+     */
+    void merge(const LatencyHistogram &other);
+
+    /**
+     * @brief Remove all values
+     */
+    void reset();
+
+    /**
+     * @brief Number of values counted
+     */
+    quint64 count() const;
+
+    /**
+     * @brief Smallest value counted
+     */
+    qint64 min() const;
+
+    /**
+     * @brief Largest value counted
+     */
+    qint64 max() const;
+
+    /**
+     * @brief Mean of the values counted
+     */
+    double mean() const;
+
+    /**
+     * @brief Value below which the given percentage of values fall
+     * @param percentile percentage between 0 and 100
+     *
+     * The result is the upper bound of the bucket containing the value, so
+     * it never underestimates the latency.
+     */
+    qint64 percentile(double percentile) const;
+
+private:
+
+    QVector<quint64> buckets;
+    quint64 samples;
+    qint64 minimum;
+    qint64 maximum;
+    double sum;
+};
+
+/**
+ * @brief Collect timings for the hot paths in the library
+ *
+ * The library only measures itself when built with the ENABLE_TRACING
+ * CMake option; otherwise the hooks compile to nothing and all histograms
+ * remain empty. The timings of each trace point are collected in a
+ * histogram and can also be written to a file in the Chrome trace event
+ * format, which can be loaded in chrome://tracing or Perfetto:
+ *
+ * @code
+ * QMdnsEngine::Tracer::startChromeTrace("trace.json");
+ * // ...
+ * QMdnsEngine::Tracer::stopChromeTrace();
+ * qint64 p99 = QMdnsEngine::Tracer::histogram(QMdnsEngine::TraceDecode).percentile(99);
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT Tracer
+{
+public:
+
+    /**
+     * @brief Determine if the library was built with tracing hooks
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Retrieve a copy of the histogram for a trace point
+     */
+    static LatencyHistogram histogram(TracePoint point);
+
+    /**
+     * @brief Clear all histograms
+     */
+    static void reset();
+
+    /**
+     * @brief Begin writing trace events to a file
+     * @param filename path of the JSON file to create
+     * @return true if the file was opened
+     */
+    static bool startChromeTrace(const QString &filename);
+
+    /**
+     * @brief Finish writing trace events and close the file
+     */
+    static void stopChromeTrace();
+
+    /**
+     * @brief Record the duration of an operation
+     * @param point trace point being measured
+     * @param start time the operation began (from now())
+     * @param duration duration of the operation in nanoseconds
+     * @param id optional identifier included in trace events, such as a listener ID
+     */
+    static void record(TracePoint point, qint64 start, qint64 duration, int id = -1);
+
+    /**
+     * @brief Current time in nanoseconds on the clock used for tracing
+     */
+    static qint64 now();
+
+    /**
+     * @brief Retrieve the name of a trace point
+     */
+    static const char *name(TracePoint point);
+};
+
+}
+
+#endif // QMDNSENGINE_TRACING_H
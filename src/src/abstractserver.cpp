@@ -23,8 +23,92 @@
  */
 
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+#include "tracing_p.h"
 
 using namespace QMdnsEngine;
 
-AbstractServer::AbstractServer() {
+AbstractServer::AbstractServer()
+    : nextListenerId(0)
+{
+}
+
+int AbstractServer::addMessageListener(const MessageListener &listener)
+{
+    int id = nextListenerId++;
+    listeners.insert(id, listener);
+    return id;
+}
+
+void AbstractServer::removeMessageListener(int id)
+{
+    listeners.remove(id);
+}
+
+void AbstractServer::dispatchMessage(const Message &message)
+{
+    QMDNSENGINE_TRACE(TraceDispatch);
+
+    // Iterate over a copy since listeners may be added or removed while the
+    // message is being delivered
+    if (message.isResponse()) {
+        ++counters.responsesReceived;
+    } else {
+        ++counters.queriesReceived;
+    }
+    const auto currentListeners = listeners;
+    for (auto i = currentListeners.constBegin(); i != currentListeners.constEnd(); ++i) {
+        if (listeners.contains(i.key())) {
+            ++counters.listenerCalls;
+            QMDNSENGINE_TRACE_ID(TraceListener, i.key());
+            i.value()(message);
+        }
+    }
+    ++counters.messageEvents;
+    publish(MessageReceived{message});
+}
+
+ServerStatistics AbstractServer::statistics() const
+{
+    return counters;
+}
+
+QObject *AbstractServer::context()
+{
+    return &lifetime;
+}
+
+void AbstractServer::reportError(const QString &message)
+{
+    ++counters.errorEvents;
+    publish(Error{message});
+}
+
+void AbstractServer::recordReceived(const QString &interfaceName, int nBytes)
+{
+    TrafficStatistics &traffic = counters.interfaces[interfaceName];
+    ++traffic.packetsReceived;
+    traffic.bytesReceived += nBytes;
+    ++counters.total.packetsReceived;
+    counters.total.bytesReceived += nBytes;
+}
+
+void AbstractServer::recordParseError(ParseError error)
+{
+    ++counters.parseErrors[error];
+}
+
+void AbstractServer::recordSent(const Message &message, const QString &interfaceName, int nBytes)
+{
+    if (message.isResponse()) {
+        ++counters.responsesSent;
+    } else {
+        ++counters.queriesSent;
+    }
+    TrafficStatistics &traffic = counters.interfaces[interfaceName];
+    ++traffic.packetsSent;
+    traffic.bytesSent += nBytes;
+    ++counters.total.packetsSent;
+    counters.total.bytesSent += nBytes;
 }
@@ -0,0 +1,191 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+
+#include "announcer_p.h"
+
+using namespace QMdnsEngine;
+
+// Each record is announced three times, one and then two seconds apart
+const int AnnouncementCount = 3;
+const int AnnouncementInterval = 1000;
+
+// Announcements due within this window of each other are sent together
+const int AnnouncementSlack = 100;
+
+static QHash<AbstractServer*, Announcer*> announcers;
+
+Announcer *Announcer::acquire(AbstractServer *server)
+{
+    Announcer *announcer = announcers.value(server);
+    if (!announcer) {
+        announcer = new Announcer(server);
+        announcers.insert(server, announcer);
+    }
+    ++announcer->refCount;
+    return announcer;
+}
+
+void Announcer::release(Announcer *announcer)
+{
+    if (!--announcer->refCount) {
+        announcers.remove(announcer->server);
+        delete announcer;
+    }
+}
+
+Announcer::Announcer(AbstractServer *server)
+    : server(server),
+      refCount(0)
+{
+    clock.start();
+    timer.callOnTimeout([this] {
+        onTimeout();
+    });
+    timer.setSingleShot(true);
+}
+
+Announcer::~Announcer()
+{
+    // The last user is going away (usually at shutdown, when the event loop
+    // may no longer be running), so send pending goodbyes immediately
+    if (!goodbyes.isEmpty()) {
+        sendRecords(goodbyes);
+    }
+}
+
+void Announcer::announce(const QList<Record> &records)
+{
+    // Replace pending announcements for the same records; the first
+    // announcement is sent on the next pass through the event loop so that
+    // everything announced in the meantime ends up in the same packets
+    qint64 now = clock.elapsed();
+    for (const Record &record : records) {
+        removeEntries(record, record.type() == PTR);
+        entries.append({record, 0, now});
+    }
+    schedule();
+}
+
+void Announcer::cancel(const QList<Record> &records)
+{
+    for (const Record &record : records) {
+        removeEntries(record, true);
+    }
+    schedule();
+}
+
+void Announcer::goodbye(const QList<Record> &records)
+{
+    // Stop announcing the records and queue them with a TTL of 0
+    for (Record record : records) {
+        removeEntries(record, true);
+        record.setTtl(0);
+        goodbyes.append(record);
+    }
+    timer.start(0);
+}
+
+void Announcer::removeEntries(const Record &record, bool sameRecordOnly)
+{
+    for (auto i = entries.begin(); i != entries.end();) {
+        if ((*i).record == record || (!sameRecordOnly &&
+                (*i).record.nameAtom() == record.nameAtom() &&
+                (*i).record.type() == record.type())) {
+            i = entries.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void Announcer::onTimeout()
+{
+    // Gather goodbyes and every announcement that is due (or nearly due) so
+    // that they can be sent in as few packets as possible
+    QList<Record> records = goodbyes;
+    goodbyes.clear();
+
+    qint64 now = clock.elapsed();
+    for (auto i = entries.begin(); i != entries.end();) {
+        if ((*i).due <= now + AnnouncementSlack) {
+            records.append((*i).record);
+            if (++(*i).sent == AnnouncementCount) {
+                i = entries.erase(i);
+                continue;
+            }
+            (*i).due = now + (AnnouncementInterval << ((*i).sent - 1));
+        }
+        ++i;
+    }
+
+    if (!records.isEmpty()) {
+        sendRecords(records);
+    }
+    schedule();
+}
+
+void Announcer::schedule()
+{
+    if (!goodbyes.isEmpty()) {
+        timer.start(0);
+        return;
+    }
+    if (entries.isEmpty()) {
+        timer.stop();
+        return;
+    }
+    qint64 due = entries.at(0).due;
+    for (const Entry &entry : entries) {
+        due = qMin(due, entry.due);
+    }
+    timer.start(qMax<qint64>(0, due - clock.elapsed()));
+}
+
+void Announcer::sendRecords(const QList<Record> &records)
+{
+    Message message;
+    message.setResponse(true);
+    int size = 12;
+    bool empty = true;
+    for (const Record &record : records) {
+        int nBytes = recordSize(record);
+        if (!empty && size + nBytes > MdnsMaxPacketSize) {
+            server->sendMessageToAll(message);
+            message = Message();
+            message.setResponse(true);
+            size = 12;
+        }
+        message.addRecord(record);
+        size += nBytes;
+        empty = false;
+    }
+    if (!empty) {
+        server->sendMessageToAll(message);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_ANNOUNCER_P_H
+#define QMDNSENGINE_ANNOUNCER_P_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+
+#include <qmdnsengine/record.h>
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+
+/*
+ * All providers and hostnames using the same server share a single
+ * announcer, which sends unsolicited responses on their behalf: each record
+ * is announced several times with doubling intervals (RFC 6762, section
+ * 8.3) and records from everyone are merged into the fewest packets
+ */
+class Announcer
+{
+public:
+
+    static Announcer *acquire(AbstractServer *server);
+    static void release(Announcer *announcer);
+
+    void announce(const QList<Record> &records);
+    void cancel(const QList<Record> &records);
+    void goodbye(const QList<Record> &records);
+
+private:
+
+    struct Entry
+    {
+        Record record;
+        int sent;
+        qint64 due;
+    };
+
+    explicit Announcer(AbstractServer *server);
+    ~Announcer();
+
+    void removeEntries(const Record &record, bool sameRecordOnly);
+    void onTimeout();
+    void schedule();
+    void sendRecords(const QList<Record> &records);
+
+    AbstractServer *server;
+    int refCount;
+    QElapsedTimer clock;
+    QTimer timer;
+    QList<Entry> entries;
+    QList<Record> goodbyes;
+};
+
+}
+
+#endif // QMDNSENGINE_ANNOUNCER_P_H
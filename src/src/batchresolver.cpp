@@ -0,0 +1,312 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <limits>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/batchresolver.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/nameatom.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "batchresolver_p.h"
+
+using namespace QMdnsEngine;
+
+// Queries are repeated one second after the first, then with doubling
+// intervals, until the host resolves or times out
+const int QueryInterval = 1000;
+const int DefaultTimeout = 3000;
+
+// Value used for hosts that no longer need to be queried
+const qint64 Never = std::numeric_limits<qint64>::max();
+
+BatchResolverPrivate::BatchResolverPrivate(BatchResolver *resolver, AbstractServer *server, Cache *cache)
+    : server(server),
+      cache(cache),
+      timeout(DefaultTimeout),
+      q(resolver)
+{
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
+    });
+
+    clock.start();
+    timer.callOnTimeout([this] {
+        onTimeout();
+    });
+    timer.setSingleShot(true);
+}
+
+BatchResolverPrivate::~BatchResolverPrivate()
+{
+    server->removeMessageListener(listenerId);
+}
+
+void BatchResolverPrivate::schedule()
+{
+    if (!cachedResults.isEmpty()) {
+        timer.start(0);
+        return;
+    }
+    qint64 next = Never;
+    for (auto i = hosts.constBegin(); i != hosts.constEnd(); ++i) {
+        next = qMin(next, qMin(i.value().deadline, i.value().nextQuery));
+    }
+    if (next == Never) {
+        timer.stop();
+    } else {
+        timer.start(qMax<qint64>(0, next - clock.elapsed()));
+    }
+}
+
+void BatchResolverPrivate::onMessageReceived(const Message &message)
+{
+    if (!message.isResponse() || hosts.isEmpty()) {
+        return;
+    }
+
+    // Pending hosts are indexed by name, so each record in the response can
+    // be matched without scanning the list of hosts
+    QList<QPair<QByteArray, QHostAddress>> results;
+    bool reschedule = false;
+    const auto records = message.records();
+    for (const Record &record : records) {
+        if (record.type() != A && record.type() != AAAA && record.type() != NSEC) {
+            continue;
+        }
+        auto i = hosts.find(record.nameAtom());
+        if (i == hosts.end()) {
+            continue;
+        }
+        if (cache) {
+            cache->addRecord(record);
+        }
+        if (record.type() == NSEC) {
+            if (record.ttl()) {
+                onNegativeResponse(record, i.value());
+                reschedule = true;
+            }
+            continue;
+        }
+        if (record.ttl() && !i.value().addresses.contains(record.address())) {
+            i.value().addresses.insert(record.address());
+            i.value().nextQuery = Never;
+            results.append({i.key().name(), record.address()});
+        }
+    }
+
+    for (const auto &result : results) {
+        q->publish(HostResolved{result.first, result.second});
+    }
+    if (reschedule) {
+        schedule();
+    }
+}
+
+void BatchResolverPrivate::onNegativeResponse(const Record &record, Host &host)
+{
+    Bitmap bitmap = record.bitmap();
+    host.noIpv4 = !bitmap.testBit(A);
+    host.noIpv6 = !bitmap.testBit(AAAA);
+
+    // A host without any addresses cannot be resolved, so there is no point
+    // in waiting for the timeout
+    if (host.noIpv4 && host.noIpv6 && host.addresses.isEmpty()) {
+        host.deadline = clock.elapsed();
+        host.nextQuery = Never;
+    }
+}
+
+void BatchResolverPrivate::onTimeout()
+{
+    qint64 now = clock.elapsed();
+
+    // Publish the addresses that were found in the cache
+    const auto results = cachedResults;
+    cachedResults.clear();
+    for (const auto &result : results) {
+        q->publish(HostResolved{result.first, result.second});
+    }
+
+    // Remove hosts whose time is up and collect those that need querying
+    QList<QByteArray> timedOut;
+    QList<NameAtom> due;
+    for (auto i = hosts.begin(); i != hosts.end();) {
+        Host &host = i.value();
+        if (host.deadline <= now) {
+            if (host.addresses.isEmpty()) {
+                timedOut.append(i.key().name());
+            }
+            i = hosts.erase(i);
+            continue;
+        }
+        if (host.nextQuery <= now) {
+            due.append(i.key());
+            host.nextQuery = now + host.interval;
+            host.interval *= 2;
+        }
+        ++i;
+    }
+
+    sendQueries(due);
+
+    for (const QByteArray &name : timedOut) {
+        q->publish(HostTimedOut{name});
+    }
+
+    schedule();
+}
+
+void BatchResolverPrivate::sendQueries(const QList<NameAtom> &names)
+{
+    // Pack the A and AAAA queries for as many hosts as will fit into each
+    // packet
+
+    Message message;
+    int size = 12;
+    bool empty = true;
+    for (const NameAtom &name : names) {
+
+        // Types that are known not to exist are not queried
+        const Host host = hosts.value(name);
+        QList<quint16> types;
+        if (!host.noIpv4) {
+            types.append(A);
+        }
+        if (!host.noIpv6) {
+            types.append(AAAA);
+        }
+        if (types.isEmpty()) {
+            continue;
+        }
+
+        Query query;
+        query.setName(name.name());
+        query.setType(A);
+        int nBytes = types.count() * querySize(query);
+        if (!empty && size + nBytes > MdnsMaxPacketSize) {
+            server->sendMessageToAll(message);
+            message = Message();
+            size = 12;
+        }
+        for (quint16 type : types) {
+            query.setType(type);
+            message.addQuery(query);
+        }
+        size += nBytes;
+        empty = false;
+    }
+    if (!empty) {
+        server->sendMessageToAll(message);
+    }
+}
+
+BatchResolver::BatchResolver(AbstractServer *server, Cache *cache)
+    : d(new BatchResolverPrivate(this, server, cache))
+{
+}
+
+BatchResolver::~BatchResolver()
+{
+    delete d;
+}
+
+void BatchResolver::resolve(const QSet<QByteArray> &names)
+{
+    qint64 now = d->clock.elapsed();
+    for (const QByteArray &name : names) {
+        NameAtom atom(name);
+        if (d->hosts.contains(atom)) {
+            continue;
+        }
+        BatchResolverPrivate::Host host{now + d->timeout, now, QueryInterval, {}};
+
+        // Hosts with addresses in the cache are resolved without a query
+        QList<Record> records;
+        if (d->cache) {
+            d->cache->lookupRecords(name, A, records);
+            d->cache->lookupRecords(name, AAAA, records);
+        }
+        for (const Record &record : records) {
+            if (!host.addresses.contains(record.address())) {
+                host.addresses.insert(record.address());
+                d->cachedResults.append({name, record.address()});
+            }
+        }
+        if (d->cache) {
+            host.noIpv4 = d->cache->hasNegativeEntry(name, A);
+            host.noIpv6 = d->cache->hasNegativeEntry(name, AAAA);
+        }
+
+        // Hosts that were resolved or that are known to have no addresses
+        // are finished on the next pass through the event loop
+        if (!host.addresses.isEmpty() || (host.noIpv4 && host.noIpv6)) {
+            host.deadline = now;
+            host.nextQuery = Never;
+        }
+
+        d->hosts.insert(atom, host);
+    }
+
+    // Queries are sent on the next pass through the event loop so that names
+    // from several calls end up in the same packets
+    d->timer.start(0);
+}
+
+void BatchResolver::cancel(const QSet<QByteArray> &names)
+{
+    for (const QByteArray &name : names) {
+        d->hosts.remove(NameAtom::find(name));
+    }
+    d->schedule();
+}
+
+int BatchResolver::pendingCount() const
+{
+    // Resolved hosts are kept until their deadline to collect any further
+    // addresses, but are no longer pending
+    int count = 0;
+    for (auto i = d->hosts.constBegin(); i != d->hosts.constEnd(); ++i) {
+        if (i.value().addresses.isEmpty()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int BatchResolver::timeout() const
+{
+    return d->timeout;
+}
+
+void BatchResolver::setTimeout(int timeout)
+{
+    d->timeout = timeout;
+}
@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_BATCHRESOLVER_P_H
+#define QMDNSENGINE_BATCHRESOLVER_P_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QTimer>
+
+#include <qmdnsengine/nameatom.h>
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class BatchResolver;
+class Cache;
+class Message;
+class Record;
+
+class BatchResolverPrivate
+{
+public:
+
+    struct Host
+    {
+        qint64 deadline;
+        qint64 nextQuery;
+        int interval;
+        QSet<QHostAddress> addresses;
+
+        // Set when a negative response shows that the type does not exist
+        bool noIpv4 = false;
+        bool noIpv6 = false;
+    };
+
+    BatchResolverPrivate(BatchResolver *resolver, AbstractServer *server, Cache *cache);
+    ~BatchResolverPrivate();
+
+    void schedule();
+
+    AbstractServer *server;
+    int listenerId;
+    Cache *cache;
+    int timeout;
+
+    // Hosts are keyed by atom so that names in responses match regardless
+    // of case; the atom keeps the spelling passed to resolve()
+    QHash<NameAtom, Host> hosts;
+    QList<QPair<QByteArray, QHostAddress>> cachedResults;
+
+    QElapsedTimer clock;
+    QTimer timer;
+
+private:
+
+    void onMessageReceived(const Message &message);
+    void onNegativeResponse(const Record &record, Host &host);
+    void onTimeout();
+    void sendQueries(const QList<NameAtom> &names);
+
+    BatchResolver *const q;
+};
+
+}
+
+#endif // QMDNSENGINE_BATCHRESOLVER_P_H
@@ -22,89 +22,150 @@
  * IN THE SOFTWARE.
  */
 
-#include <qmdnsengine/bitmap.h>
+#include <cstring>
 
-#include "bitmap_p.h"
+#include <qmdnsengine/bitmap.h>
 
 using namespace QMdnsEngine;
 
-BitmapPrivate::BitmapPrivate()
-    : length(0),
-      data(nullptr)
+Bitmap::Bitmap()
+    : firstWindowLength(0),
+      firstWindow{}
 {
 }
 
-BitmapPrivate::~BitmapPrivate()
+bool Bitmap::operator==(const Bitmap &other) const
 {
-    free();
+    return firstWindowLength == other.firstWindowLength &&
+        memcmp(firstWindow, other.firstWindow, firstWindowLength) == 0 &&
+        otherWindows == other.otherWindows;
 }
 
-void BitmapPrivate::free()
+quint8 Bitmap::length() const
 {
-    if (data) {
-        delete[] data;
-    }
+    return firstWindowLength;
 }
 
-void BitmapPrivate::fromData(quint8 newLength, const quint8 *newData)
+const quint8 *Bitmap::data() const
 {
-    data = new quint8[newLength];
-    for (int i = 0; i < newLength; ++i) {
-        data[i] = newData[i];
-    }
-    length = newLength;
+    return firstWindow;
 }
 
-Bitmap::Bitmap()
-    : d(new BitmapPrivate)
+void Bitmap::setData(quint8 length, const quint8 *data)
 {
+    firstWindowLength = qMin<int>(length, MaxLength);
+    if (firstWindowLength) {
+        memcpy(firstWindow, data, firstWindowLength);
+    }
+    memset(firstWindow + firstWindowLength, 0, MaxLength - firstWindowLength);
 }
 
-Bitmap::Bitmap(const Bitmap &other)
-    : d(new BitmapPrivate)
+bool Bitmap::isEmpty() const
 {
-    d->fromData(other.d->length, other.d->data);
+    for (int i = 0; i < firstWindowLength; ++i) {
+        if (firstWindow[i]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < otherWindows.length();) {
+        int length = static_cast<quint8>(otherWindows.at(i + 1));
+        for (int j = 0; j < length; ++j) {
+            if (otherWindows.at(i + 2 + j)) {
+                return false;
+            }
+        }
+        i += 2 + length;
+    }
+    return true;
 }
 
-Bitmap &Bitmap::operator=(const Bitmap &other)
+bool Bitmap::testBit(quint16 type) const
 {
-    if (this != &other) {
-        d->free();
-        d->fromData(other.d->length, other.d->data);
+    if (!windowOf(type)) {
+        return testBit(firstWindow, firstWindowLength, type);
+    }
+    for (int i = 0; i < otherWindows.length();) {
+        quint8 window = otherWindows.at(i);
+        int length = static_cast<quint8>(otherWindows.at(i + 1));
+        if (window == windowOf(type)) {
+            return testBit(reinterpret_cast<const quint8*>(otherWindows.constData() + i + 2), length, type);
+        }
+        i += 2 + length;
     }
-    return *this;
+    return false;
 }
 
-bool Bitmap::operator==(const Bitmap &other)
+void Bitmap::setBit(quint16 type)
 {
-    if (d->length != other.d->length) {
-        return false;
+    int byte = byteOf(type);
+    if (!windowOf(type)) {
+        if (byte >= firstWindowLength) {
+            firstWindowLength = byte + 1;
+        }
+        firstWindow[byte] |= maskOf(type);
+        return;
     }
-    for (int i = 0; i < d->length; ++i) {
-        if (d->data[i] != other.d->data[i]) {
-            return false;
+
+    // Find the window or the position where it must be inserted
+    int i = 0;
+    while (i < otherWindows.length()) {
+        quint8 window = otherWindows.at(i);
+        if (window >= windowOf(type)) {
+            break;
         }
+        i += 2 + static_cast<quint8>(otherWindows.at(i + 1));
+    }
+    if (i == otherWindows.length() || static_cast<quint8>(otherWindows.at(i)) != windowOf(type)) {
+        char header[] = { static_cast<char>(windowOf(type)), 0 };
+        otherWindows.insert(i, header, 2);
     }
-    return true;
-}
 
-Bitmap::~Bitmap()
-{
-    delete d;
+    // Extend the window if the byte is not yet part of it
+    int length = static_cast<quint8>(otherWindows.at(i + 1));
+    if (byte >= length) {
+        otherWindows.insert(i + 2 + length, QByteArray(byte + 1 - length, 0));
+        otherWindows[i + 1] = static_cast<char>(byte + 1);
+    }
+    otherWindows[i + 2 + byte] = static_cast<char>(otherWindows.at(i + 2 + byte) | maskOf(type));
 }
 
-quint8 Bitmap::length() const
+int Bitmap::wireLength() const
 {
-    return d->length;
+    return (firstWindowLength ? 2 + firstWindowLength : 0) + otherWindows.length();
 }
 
-const quint8 *Bitmap::data() const
+void Bitmap::toWire(QByteArray &packet) const
 {
-    return d->data;
+    if (firstWindowLength) {
+        packet.append('\0');
+        packet.append(static_cast<char>(firstWindowLength));
+        packet.append(reinterpret_cast<const char*>(firstWindow), firstWindowLength);
+    }
+    packet.append(otherWindows);
 }
 
-void Bitmap::setData(quint8 length, const quint8 *data)
+bool Bitmap::fromWire(const char *data, int length)
 {
-    d->free();
-    d->fromData(length, data);
+    Bitmap bitmap;
+    int previous = -1;
+    for (int i = 0; i < length;) {
+        if (i + 2 > length) {
+            return false;
+        }
+        int window = static_cast<quint8>(data[i]);
+        int windowLength = static_cast<quint8>(data[i + 1]);
+        if (window <= previous || windowLength < 1 || windowLength > MaxLength ||
+                i + 2 + windowLength > length) {
+            return false;
+        }
+        if (window == 0) {
+            bitmap.setData(windowLength, reinterpret_cast<const quint8*>(data + i + 2));
+        } else {
+            bitmap.otherWindows.append(data + i, 2 + windowLength);
+        }
+        previous = window;
+        i += 2 + windowLength;
+    }
+    *this = bitmap;
+    return true;
 }
@@ -22,7 +22,8 @@
  * IN THE SOFTWARE.
  */
 
-#include <utility>
+#include <QDateTime>
+#include <QSet>
 
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/browser.h>
@@ -34,25 +35,106 @@
 #include <qmdnsengine/record.h>
 
 #include "browser_p.h"
+#include "refresh_p.h"
+#include "sharedcache_p.h"
 
 using namespace QMdnsEngine;
 
+// Records of a set being flushed that were received within this interval
+// are kept, since they are part of the new set (the cache does the same)
+const qint64 FlushInterval = 1000;
+
+void BrowserPrivate::RecordSet::insert(const Record &record)
+{
+    // A record that is received again keeps its place, so that the order of
+    // the records does not change each time the set is announced
+    QDateTime now = QDateTime::currentDateTime();
+    bool found = false;
+    for (auto i = entries.begin(); i != entries.end();) {
+        if (i->record == record) {
+            i->record = record;
+            i->received = now;
+            found = true;
+        } else if (record.flushCache() && i->record.type() == record.type() &&
+                (!i->received.isValid() || i->received.msecsTo(now) > FlushInterval)) {
+            i = entries.erase(i);
+            continue;
+        }
+        ++i;
+    }
+    if (!found) {
+        entries.append({record, now});
+    }
+}
+
+bool BrowserPrivate::RecordSet::remove(const Record &record)
+{
+    for (auto i = entries.begin(); i != entries.end(); ++i) {
+        if (i->record == record) {
+            entries.erase(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void BrowserPrivate::RecordSet::load(Cache *cache, const QByteArray &name, quint16 type)
+{
+    // The time cached records were received is not known, so they are
+    // replaced by the next set that is flushed
+    QList<Record> cachedRecords;
+    cache->lookupRecords(name, type, cachedRecords);
+    for (const Record &record : cachedRecords) {
+        entries.append({record, QDateTime()});
+    }
+}
+
+QList<Record> BrowserPrivate::RecordSet::records() const
+{
+    QList<Record> records;
+    for (const Entry &entry : entries) {
+        records.append(entry.record);
+    }
+    return records;
+}
+
 BrowserPrivate::BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray& serviceType, Cache *existingCache)
     : server(server),
-      _serviceType(serviceType),
-      cache(existingCache ? existingCache : new Cache()),
+      serviceTypeAtom(serviceType),
+      serviceTypeName(serviceType),
+      enumerateTypes(serviceType == MdnsBrowseType),
+      cache(existingCache),
+      sharedCache(nullptr),
+      version(0),
+      batchInterval(-1),
       q(browser)
 {
-    server->on<MessageReceived>([this](const MessageReceived& event, const AbstractServer&) {
-        onMessageReceived(event.message);
-    });
-    cache->on<ShouldQuery>([this](const ShouldQuery& event, const Cache&) {
-        onShouldQuery(event.record);
-    });
-    cache->on<RecordExpired>([this](const RecordExpired& event, const Cache&) {
-        onRecordExpired(event.record);
+    if (!enumerateTypes) {
+        serviceTypes.insert(serviceTypeAtom);
+    }
+
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
     });
 
+    if (cache) {
+        cache->on<ShouldQuery>([this](const ShouldQuery& event, const Cache&) {
+            onShouldQuery(event.records);
+        });
+        cache->on<RecordExpired>([this](const RecordExpired& event, const Cache&) {
+            onRecordExpired(event.record);
+        });
+    } else {
+        // Without a cache of its own, the browser uses the one shared by
+        // everyone on the server, which also takes care of refresh queries
+        sharedCache = SharedCache::acquire(server);
+        cache = sharedCache->cache();
+        cacheListenerId = sharedCache->addListener([this](const Record &record) {
+            onRecordExpired(record);
+        });
+        addInterest(serviceType);
+    }
+
     queryTimer.callOnTimeout([this] {
         sendQuery();
     });
@@ -60,183 +142,706 @@ BrowserPrivate::BrowserPrivate(Browser *browser, AbstractServer *server, const Q
     queryTimer.setInterval(60 * 1000);
     queryTimer.setSingleShot(true);
 
+    // Services already in the cache (restored from a snapshot, for example)
+    // are reported once control returns to the event loop, giving the caller
+    // a chance to register handlers first
+    cacheTimer.callOnTimeout([this] {
+        loadCachedServices();
+    });
+    cacheTimer.setSingleShot(true);
+    cacheTimer.start(0);
+
+    // Follow-up queries are sent once control returns to the event loop so
+    // that those for services found at the same time are combined
+    followUpTimer.callOnTimeout([this] {
+        sendFollowUpQueries();
+    });
+    followUpTimer.setSingleShot(true);
+
+    batchTimer.callOnTimeout([this] {
+        publishBatch();
+    });
+    batchTimer.setSingleShot(true);
+
     // Immediately begin browsing for services
     sendQuery();
 }
 
-// TODO: multiple SRV records not supported
+BrowserPrivate::~BrowserPrivate()
+{
+    server->removeMessageListener(listenerId);
+    if (sharedCache) {
+        sharedCache->removeListener(cacheListenerId);
+        SharedCache::release(sharedCache);
+    } else {
+        cache->reset<ShouldQuery>();
+        cache->reset<RecordExpired>();
+    }
+}
 
-bool BrowserPrivate::updateService(const QByteArray &fqName)
+void BrowserPrivate::addInterest(const QByteArray &name)
 {
-    // Split the FQDN into service name and type
-    int index = fqName.indexOf('.');
-    QByteArray serviceName = fqName.left(index);
-    QByteArray serviceType = fqName.mid(index + 1);
+    if (sharedCache) {
+        sharedCache->addInterest(cacheListenerId, name);
+    }
+}
+
+void BrowserPrivate::removeInterest(const QByteArray &name)
+{
+    if (sharedCache) {
+        sharedCache->removeInterest(cacheListenerId, name);
+    }
+}
+
+bool BrowserPrivate::isInstance(const QByteArray &name) const
+{
+    if (!enumerateTypes) {
+        return serviceTypeName.isParentOf(name);
+    }
+    int index = name.indexOf('.');
+    return index != -1 && serviceTypes.contains(NameAtom::find(name.mid(index + 1)));
+}
+
+void BrowserPrivate::addServiceType(const QByteArray &type)
+{
+    // Services of each type found are browsed for, combining the queries
+    // for all of the types found at the same time
+    NameAtom typeAtom(type);
+    if (!serviceTypes.contains(typeAtom)) {
+        serviceTypes.insert(typeAtom);
+        addInterest(type);
+        queueQuery(type, PTR);
+    }
+}
+
+BrowserPrivate::ServiceState &BrowserPrivate::state(const NameAtom &fqName)
+{
+    // Keep the spelling the service was first seen with, which names the
+    // published service for as long as it exists
+    ServiceState &state = _states[fqName];
+    if (state.fqName.isNull()) {
+        state.fqName = fqName;
+    }
+    return state;
+}
 
-    // Immediately return if a PTR record does not exist
-    Record ptrRecord;
-    if (!cache->lookupRecord(serviceType, PTR, ptrRecord)) {
-        return false;
+void BrowserPrivate::setSrvRecord(ServiceState &state, const Record &record)
+{
+    NameAtom hostname(record.target());
+    if (hostname != state.hostname) {
+        linkHost(hostname, state.fqName);
+        if (!state.hostname.isNull()) {
+            unlinkHost(state.hostname, state.fqName);
+        }
+        state.hostname = hostname;
     }
+    state.srvRecord = record;
+}
+
+void BrowserPrivate::addTxtRecord(ServiceState &state, const Record &record)
+{
+    state.txtRecords.insert(record);
+    updateTxtData(state);
+}
 
-    // If a SRV record is missing, query for it (by returning true)
-    Record srvRecord;
-    if (!cache->lookupRecord(fqName, SRV, srvRecord)) {
-        return true;
+void BrowserPrivate::updateTxtData(ServiceState &state)
+{
+    QByteArray txtData;
+    const QList<Record> records = state.txtRecords.records();
+    for (const Record &record : records) {
+        txtData.append(record.txtData());
     }
 
+    // The attributes are only parsed again if the raw TXT data changed,
+    // which is rarely the case when records are refreshed
+    if (txtData != state.txtData) {
+        state.txtData = txtData;
+        Record txtRecord;
+        txtRecord.setTxtData(txtData);
+        state.attributes = txtData.isEmpty() ?
+            QMap<QByteArray, QByteArray>() : txtRecord.attributes();
+    }
+}
+
+// TODO: multiple SRV records not supported
+
+void BrowserPrivate::updateService(ServiceState &state)
+{
+    // A service is reported once both its PTR and SRV records are known
+    if (state.srvRecord.type() != SRV || (!state.published && !state.ptrSeen)) {
+        return;
+    }
+
+    // Split the FQDN into service name and type
+    QByteArray fqName = state.fqName.name();
+    int index = fqName.indexOf('.');
     Service service;
-    service.setName(serviceName);
-    service.setType(serviceType);
-    service.setHostname(srvRecord.target());
-    service.setPort(srvRecord.port());
-
-    // If TXT records are available for the service, add their values
-    QList<Record> txtRecords;
-    if (cache->lookupRecords(fqName, TXT, txtRecords)) {
-        QMap<QByteArray, QByteArray> attributes;
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-		for (const Record &record : std::as_const(txtRecords)) {
-#else
-		for (const Record &record : qAsConst(txtRecords)) {
-#endif
-            for (auto i = record.attributes().constBegin();
-                    i != record.attributes().constEnd(); ++i) {
-                attributes.insert(i.key(), i.value());
-            }
+    service.setName(fqName.left(index));
+    service.setType(fqName.mid(index + 1));
+    service.setHostname(state.srvRecord.target());
+    service.setPort(state.srvRecord.port());
+    service.setAttributes(state.attributes);
+
+    QList<QHostAddress> addresses;
+    auto host = _hosts.constFind(state.hostname);
+    if (host != _hosts.constEnd()) {
+        const QList<Record> records = host->addressRecords.records();
+        for (const Record &record : records) {
+            addresses.append(record.address());
         }
-        service.setAttributes(attributes);
     }
+    service.setAddresses(addresses);
 
     // If the service existed, this is an update; otherwise it is a new
     // addition; emit the appropriate signal
-    if (!_services.contains(fqName)) {
-        q->publish(ServiceAdded{service});
-    } else if(_services.value(fqName) != service) {
-        q->publish(ServiceUpdated{service});
+    if (!state.published) {
+        state.published = true;
+        state.service = service;
+        publishChange(Added, state.fqName, service);
+    } else if (state.service != service || state.service.hostname() != service.hostname()) {
+        state.service = service;
+        publishChange(Updated, state.fqName, service);
+    }
+
+    // Once the addresses are known, the service can be connected to
+    if (addresses.isEmpty()) {
+        state.resolved = false;
+    } else if (!state.resolved) {
+        state.resolved = true;
+        if (batchInterval < 0) {
+            q->publish(ServiceResolved{service});
+        } else if (!pendingResolved.contains(state.fqName)) {
+            pendingResolved.append(state.fqName);
+        }
     }
+}
 
-    _services.insert(fqName, service);
-    _hostnames.insert(service.hostname());
+void BrowserPrivate::removeService(ServiceState &state)
+{
+    NameAtom fqName = state.fqName;
+    Service service = state.service;
+    bool published = state.published;
 
-    return false;
+    if (!state.hostname.isNull()) {
+        unlinkHost(state.hostname, fqName);
+    }
+
+    // Only the PTR record is kept (if there is one), since interest in the
+    // other records is released
+    if (state.ptrSeen) {
+        state.srvRecord = Record();
+        state.hostname = NameAtom();
+        state.txtRecords.clear();
+        state.txtData.clear();
+        state.attributes.clear();
+        state.service = Service();
+        state.published = false;
+        state.resolved = false;
+        state.queried = false;
+    } else {
+        _states.remove(fqName);
+    }
+    removeInterest(fqName.name());
+
+    if (published) {
+        publishChange(Removed, fqName, service);
+    }
+}
+
+void BrowserPrivate::publishChange(ChangeType type, const NameAtom &fqName, const Service &service)
+{
+    // Record the change for snapshots and changesSince(), dropping the
+    // oldest changes once there are too many
+    QByteArray name = fqName.name();
+    if (type == Removed) {
+        services.remove(name);
+    } else {
+        services.insert(name, service);
+    }
+    LoggedChange change{++version, type, fqName, service};
+    changeLog.append(change);
+    if (changeLog.length() > MaxLoggedChanges) {
+        changeLog.removeFirst();
+    }
+
+    if (batchInterval < 0) {
+        switch (type) {
+        case Added:
+            q->publish(ServiceAdded{service});
+            break;
+        case Updated:
+            q->publish(ServiceUpdated{service});
+            break;
+        case Removed:
+            q->publish(ServiceRemoved{service});
+            break;
+        }
+        return;
+    }
+
+    mergeChange(pendingOrder, pendingChanges, type, fqName, service);
+    if (!batchTimer.isActive()) {
+        batchTimer.start(batchInterval);
+    }
+}
+
+void BrowserPrivate::publishBatch()
+{
+    batchTimer.stop();
+
+    QList<Service> added;
+    QList<Service> updated;
+    QList<Service> removed;
+    collectChanges(pendingOrder, pendingChanges, added, updated, removed);
+    pendingOrder.clear();
+    pendingChanges.clear();
+
+    if (!added.isEmpty() || !updated.isEmpty() || !removed.isEmpty()) {
+        q->publish(ServicesChanged{added, updated, removed});
+    }
+
+    // Services are only reported as resolved once the batch adding them has
+    // been published, and only if they are still resolved
+    const QList<NameAtom> resolved = pendingResolved;
+    pendingResolved.clear();
+    for (const NameAtom &fqName : resolved) {
+        auto i = _states.constFind(fqName);
+        if (i != _states.constEnd() && i->published && i->resolved) {
+            q->publish(ServiceResolved{i->service});
+        }
+    }
+}
+
+void BrowserPrivate::mergeChange(QList<NameAtom> &order, QHash<NameAtom, Change> &changes,
+                                 ChangeType type, const NameAtom &fqName, const Service &service)
+{
+    // Combine the change with an earlier one for the service so that each
+    // service appears once, in its latest state
+    auto i = changes.find(fqName);
+    if (i == changes.end()) {
+        changes.insert(fqName, {type, service});
+        order.append(fqName);
+    } else if (i->type == Added && type == Removed) {
+        changes.erase(i);
+        order.removeOne(fqName);
+    } else {
+        if (i->type == Removed) {
+            i->type = Updated;
+        } else if (i->type == Updated) {
+            i->type = type;
+        }
+        i->service = service;
+    }
+}
+
+void BrowserPrivate::collectChanges(const QList<NameAtom> &order, const QHash<NameAtom, Change> &changes,
+                                    QList<Service> &added, QList<Service> &updated, QList<Service> &removed)
+{
+    for (const NameAtom &fqName : order) {
+        const Change change = changes.value(fqName);
+        switch (change.type) {
+        case Added:
+            added.append(change.service);
+            break;
+        case Updated:
+            updated.append(change.service);
+            break;
+        case Removed:
+            removed.append(change.service);
+            break;
+        }
+    }
+}
+
+void BrowserPrivate::linkHost(const NameAtom &hostname, const NameAtom &fqName)
+{
+    auto i = _hosts.find(hostname);
+    if (i == _hosts.end()) {
+        i = _hosts.insert(hostname, HostState());
+        addInterest(hostname.name());
+
+        // Addresses that are already cached (by a resolver sharing the
+        // cache, for example) are used right away
+        i->addressRecords.load(cache, hostname.name(), A);
+        i->addressRecords.load(cache, hostname.name(), AAAA);
+    }
+    i->services.insert(fqName);
+}
+
+void BrowserPrivate::unlinkHost(const NameAtom &hostname, const NameAtom &fqName)
+{
+    // Release interest in the addresses of hosts no longer providing services
+    auto i = _hosts.find(hostname);
+    if (i != _hosts.end() && i->services.remove(fqName) && i->services.isEmpty()) {
+        _hosts.erase(i);
+        removeInterest(hostname.name());
+    }
+}
+
+void BrowserPrivate::addAddressRecord(HostState &host, const Record &record)
+{
+    host.addressRecords.insert(record);
+    host.queried = false;
+}
+
+void BrowserPrivate::queueFollowUpQueries(ServiceState &state)
+{
+    // Records missing for a new service are asked for once; records that
+    // are known not to exist are not
+    QByteArray fqName = state.fqName.name();
+    if (state.ptrSeen && !state.queried) {
+        state.queried = true;
+        if (state.srvRecord.type() != SRV && !cache->hasNegativeEntry(fqName, SRV)) {
+            queueQuery(fqName, SRV);
+        }
+        if (state.txtRecords.isEmpty() && !cache->hasNegativeEntry(fqName, TXT)) {
+            queueQuery(fqName, TXT);
+        }
+    }
+
+    auto host = _hosts.find(state.hostname);
+    if (host != _hosts.end() && host->addressRecords.isEmpty() && !host->queried) {
+        host->queried = true;
+        QByteArray hostname = state.hostname.name();
+        if (!cache->hasNegativeEntry(hostname, A)) {
+            queueQuery(hostname, A);
+        }
+        if (!cache->hasNegativeEntry(hostname, AAAA)) {
+            queueQuery(hostname, AAAA);
+        }
+    }
+}
+
+void BrowserPrivate::queueQuery(const QByteArray &name, quint16 type)
+{
+    QPair<QByteArray, quint16> query(name, type);
+    if (!pendingQueries.contains(query)) {
+        pendingQueries.append(query);
+    }
+    if (!followUpTimer.isActive()) {
+        followUpTimer.start(0);
+    }
+}
+
+void BrowserPrivate::sendFollowUpQueries()
+{
+    QList<Query> queries;
+    const auto pending = pendingQueries;
+    pendingQueries.clear();
+    for (const auto &nameAndType : pending) {
+        Query query;
+        query.setName(nameAndType.first);
+        query.setType(nameAndType.second);
+        queries.append(query);
+    }
+    sendQueries(server, cache, queries);
 }
 
 void BrowserPrivate::onMessageReceived(const Message& message) {
     if (!message.isResponse()) {
+
+        // The shared cache observes queries itself
+        if (!sharedCache) {
+            cache->observeQuery(message);
+        }
         return;
     }
 
-    // Use a set to track all services that are updated in the message to
-    // prevent unnecessary queries for SRV and TXT records
-    QSet<QByteArray> updateNames;
+    // Update the state of each service from the records in the message and
+    // only assemble the services affected once all of them are processed;
+    // records with a TTL of 0 are applied when the cache expires them
+    QSet<NameAtom> updateNames;
+    QList<Record> addressRecords;
     const auto records = message.records();
     for (const Record &record : records) {
-        bool cacheRecord = false;
-
         switch (record.type()) {
         case PTR:
-            if (record.name() == _serviceType) {
-                updateNames.insert(record.target());
-                cacheRecord = true;
+            if (enumerateTypes && record.nameAtom() == serviceTypeAtom) {
+                cache->addRecord(record);
+                if (record.ttl()) {
+                    addServiceType(record.target());
+                }
+            } else if (serviceTypes.contains(record.nameAtom())) {
+                cache->addRecord(record);
+                if (record.ttl()) {
+                    NameAtom fqName(record.target());
+                    state(fqName).ptrSeen = true;
+                    updateNames.insert(fqName);
+                }
             }
             break;
         case SRV:
+            if (isInstance(record.name())) {
+                addInterest(record.name());
+                cache->addRecord(record);
+                if (record.ttl()) {
+                    setSrvRecord(state(record.nameAtom()), record);
+                    updateNames.insert(record.nameAtom());
+                }
+            }
+            break;
         case TXT:
-            if (record.name().endsWith("." + _serviceType)) {
-                updateNames.insert(record.name());
-                cacheRecord = true;
+            if (isInstance(record.name())) {
+                addInterest(record.name());
+                cache->addRecord(record);
+                if (record.ttl()) {
+                    addTxtRecord(state(record.nameAtom()), record);
+                    updateNames.insert(record.nameAtom());
+                }
             }
             break;
-        }
-        if (cacheRecord) {
-            cache->addRecord(record);
+        case NSEC:
+            if (isInstance(record.name()) || _hosts.contains(record.nameAtom())) {
+                cache->addRecord(record);
+            }
+            break;
+        case A:
+        case AAAA:
+            addressRecords.append(record);
+            break;
         }
     }
 
-    // For each of the services marked to be updated, perform the update and
-    // make a list of all missing SRV records
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-    for (const QByteArray &name : std::as_const(updateNames)) {
-#else
-    for (const QByteArray &name : qAsConst(updateNames)) {
-#endif
-        updateService(name);
+    // Address records are processed after services to ensure hostnames are
+    // known
+    for (const Record &record : addressRecords) {
+        if (!_hosts.contains(record.nameAtom())) {
+            continue;
+        }
+        cache->addRecord(record);
+        auto host = _hosts.find(record.nameAtom());
+        if (record.ttl() && host != _hosts.end()) {
+            addAddressRecord(*host, record);
+            updateNames.unite(host->services);
+        }
     }
 
-    // Cache A / AAAA records after services are processed to ensure hostnames are known
-    for (const Record &record : records) {
-        bool cacheRecord = false;
-
-        switch (record.type()) {
-            case A:
-            case AAAA:
-                cacheRecord = _hostnames.contains(record.name());
-                break;
-        }
-        if (cacheRecord) {
-            cache->addRecord(record);
+    for (const NameAtom &name : updateNames) {
+        auto i = _states.find(name);
+        if (i != _states.end()) {
+            updateService(*i);
+            queueFollowUpQueries(*i);
         }
     }
 }
 
-void BrowserPrivate::onShouldQuery(const Record &record)
+void BrowserPrivate::onShouldQuery(const QList<Record> &records)
 {
     // Assume that all messages in the cache are still in use (by the browser)
     // and attempt to renew them immediately
 
-    Query query;
-    query.setName(record.name());
-    query.setType(record.type());
-    Message message;
-    message.addQuery(query);
-    server->sendMessageToAll(message);
+    sendRefreshQueries(server, cache, records);
 }
 
 void BrowserPrivate::onRecordExpired(const Record &record)
 {
-    // If the SRV record has expired for a service, then it must be
-    // removed - TXT records on the other hand, cause an update
+    // If the PTR or SRV record has expired for a service, then it must be
+    // removed - TXT and address records on the other hand, cause an update
 
-    QByteArray serviceName;
     switch (record.type()) {
+    case PTR:
+        if (serviceTypes.contains(record.nameAtom())) {
+            auto i = _states.find(NameAtom::find(record.target()));
+            if (i != _states.end()) {
+                i->ptrSeen = false;
+                if (i->srvRecord.type() == SRV || !i->txtRecords.isEmpty()) {
+                    removeService(*i);
+                } else {
+                    _states.erase(i);
+                }
+            }
+        }
+        break;
     case SRV:
-        serviceName = record.name();
+    {
+        auto i = _states.find(record.nameAtom());
+        if (i != _states.end() && i->srvRecord == record) {
+            removeService(*i);
+        }
         break;
+    }
     case TXT:
-        updateService(record.name());
-        return;
-    default:
+    {
+        auto i = _states.find(record.nameAtom());
+        if (i != _states.end() && i->txtRecords.remove(record)) {
+            updateTxtData(*i);
+            updateService(*i);
+        }
+        break;
+    }
+    case A:
+    case AAAA:
+    {
+        auto host = _hosts.find(record.nameAtom());
+        if (host != _hosts.end() && host->addressRecords.remove(record)) {
+            const auto services = host->services;
+            for (const NameAtom &fqName : services) {
+                auto i = _states.find(fqName);
+                if (i != _states.end()) {
+                    updateService(*i);
+                }
+            }
+        }
+        break;
+    }
+    }
+}
+
+void BrowserPrivate::loadCachedServices()
+{
+    // When enumerating types, the types are loaded first
+    if (enumerateTypes) {
+        QList<Record> typeRecords;
+        cache->lookupRecords(serviceTypeAtom.name(), PTR, typeRecords);
+        const QList<Record> records = typeRecords;
+        for (const Record &record : records) {
+            addServiceType(record.target());
+        }
+    }
+
+    const QSet<NameAtom> types = serviceTypes;
+    for (const NameAtom &type : types) {
+        loadCachedServices(type.name());
+    }
+}
+
+void BrowserPrivate::loadCachedServices(const QByteArray &type)
+{
+    QList<Record> ptrRecords;
+    if (!cache->lookupRecords(type, PTR, ptrRecords)) {
         return;
     }
-    Service service = _services.value(serviceName);
-    if (!service.name().isNull()) {
-        q->publish(ServiceRemoved{service});
-        _services.remove(serviceName);
-        updateHostnames();
+    const QList<Record> records = ptrRecords;
+    for (const Record &record : records) {
+        ServiceState &serviceState = state(NameAtom(record.target()));
+        if (serviceState.published) {
+            continue;
+        }
+        serviceState.ptrSeen = true;
+        QByteArray fqName = serviceState.fqName.name();
+        addInterest(fqName);
+
+        // This is the only time the cache is searched for the records
+        QList<Record> srvRecords;
+        if (cache->lookupRecords(fqName, SRV, srvRecords)) {
+            setSrvRecord(serviceState, srvRecords.last());
+        }
+        serviceState.txtRecords.clear();
+        serviceState.txtRecords.load(cache, fqName, TXT);
+        updateTxtData(serviceState);
+        updateService(serviceState);
+        queueFollowUpQueries(serviceState);
     }
 }
 
 void BrowserPrivate::sendQuery() {
+
+    // Responders answer PTR queries for the service type with the instances
+    // they provide; those already known are listed as known answers so that
+    // they are not sent again
+    QList<Query> queries;
     Query query;
-    query.setName(_serviceType);
-    query.setType(SRV);
-    Message message;
-    message.addQuery(query);
+    query.setName(serviceTypeAtom.name());
+    query.setType(PTR);
+    queries.append(query);
+    if (enumerateTypes) {
+        const QSet<NameAtom> types = serviceTypes;
+        for (const NameAtom &type : types) {
+            query.setName(type.name());
+            queries.append(query);
+        }
+    }
+    sendQueries(server, cache, queries);
 
-    server->sendMessageToAll(message);
     queryTimer.start();
 }
 
-void BrowserPrivate::updateHostnames() {
-    _hostnames.clear();
+Browser::Browser(AbstractServer *server, const QByteArray &type, Cache *cache)
+    : d(new BrowserPrivate(this, server, type, cache))
+{
+}
+
+Browser::~Browser()
+{
+    delete d;
+}
+
+int Browser::batchInterval() const
+{
+    return d->batchInterval;
+}
+
+BrowserSnapshot Browser::snapshot() const
+{
+    BrowserSnapshot snapshot;
+    snapshot.version = d->version;
+    snapshot.services = d->services;
+    return snapshot;
+}
+
+ServiceChanges Browser::changesSince(quint64 version) const
+{
+    ServiceChanges changes;
+    changes.version = d->version;
+    if (version == d->version) {
+        changes.complete = true;
+        return changes;
+    }
+
+    // The changes are only available if the log reaches back far enough
+    if (version > d->version || d->changeLog.isEmpty() ||
+            version + 1 < d->changeLog.first().version) {
+        changes.complete = false;
+        return changes;
+    }
 
-    for (const auto& service : _services) {
-        _hostnames.insert(service.hostname());
+    // Since the versions in the log are consecutive, the first change
+    // needed is found directly
+    QList<NameAtom> order;
+    QHash<NameAtom, BrowserPrivate::Change> merged;
+    int first = version + 1 - d->changeLog.first().version;
+    for (int i = first; i < d->changeLog.length(); ++i) {
+        const BrowserPrivate::LoggedChange &change = d->changeLog.at(i);
+        BrowserPrivate::mergeChange(order, merged, change.type, change.fqName, change.service);
     }
+    BrowserPrivate::collectChanges(order, merged, changes.added, changes.updated, changes.removed);
+    changes.complete = true;
+    return changes;
 }
 
-Browser::Browser(AbstractServer *server, const QByteArray &type, Cache *cache)
-    : d(new BrowserPrivate(this, server, type, cache))
+void Browser::setBatchInterval(int interval)
+{
+    // Changes collected so far are published right away when batching is
+    // disabled; otherwise, they are included in the next batch
+    d->batchInterval = interval;
+    if (interval < 0) {
+        d->publishBatch();
+    } else if (d->batchTimer.isActive()) {
+        d->batchTimer.start(interval);
+    }
+}
+
+Future<QList<Service>> QMdnsEngine::browseSnapshot(AbstractServer *server, const QByteArray &type, int window, Cache *cache)
 {
+    Promise<QList<Service>> promise;
+
+    // The browser keeps track of the services while the window is open
+    Browser *browser = new Browser(server, type, cache);
+
+    // The browser belongs to an object owned by the server so that it is
+    // destroyed before the server if the server goes away first, in which
+    // case the future is finished with the services found so far
+    QObject *owner = new QObject(server->context());
+    QObject::connect(owner, &QObject::destroyed, [promise, browser] {
+        QList<Service> services = browser->snapshot().services.values();
+        delete browser;
+        if (!promise.isFinished()) {
+            promise.finish(services);
+        }
+    });
+    QTimer::singleShot(window, owner, [owner] {
+        owner->deleteLater();
+    });
+
+    return promise.future();
 }
@@ -26,11 +26,18 @@
 #define QMDNSENGINE_BROWSER_P_H
 
 #include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
 #include <QMap>
 #include <QObject>
+#include <QPair>
 #include <QSet>
 #include <QTimer>
 
+#include <qmdnsengine/domainname.h>
+#include <qmdnsengine/nameatom.h>
+#include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
 
 namespace QMdnsEngine
@@ -40,30 +47,162 @@ class AbstractServer;
 class Browser;
 class Cache;
 class Message;
-class Record;
+class SharedCache;
 
 class BrowserPrivate {
 public:
     explicit BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray& serviceType, Cache *existingCache);
+    ~BrowserPrivate();
 
-    bool updateService(const QByteArray &fqName);
+    // Records of one name (TXT records or addresses) along with the time
+    // each one was received, so that the cache-flush bit is applied the way
+    // the cache applies it: records received within the last second belong
+    // to the new set
+    struct RecordSet
+    {
+        struct Entry
+        {
+            Record record;
+            QDateTime received;
+        };
+
+        void insert(const Record &record);
+        bool remove(const Record &record);
+        void load(Cache *cache, const QByteArray &name, quint16 type);
+        QList<Record> records() const;
+        bool isEmpty() const { return entries.isEmpty(); }
+        void clear() { entries.clear(); }
+
+        QList<Entry> entries;
+    };
+
+    // Records known for a service instance, updated from each record that
+    // is received or expires so that services are assembled without
+    // searching the cache
+    struct ServiceState
+    {
+        NameAtom fqName;
+        bool ptrSeen = false;
+        Record srvRecord;
+        NameAtom hostname;
+        RecordSet txtRecords;
+        QByteArray txtData;
+        QMap<QByteArray, QByteArray> attributes;
+
+        // Last service published
+        Service service;
+        bool published = false;
+        bool resolved = false;
+        bool queried = false;
+    };
+
+    // Changes to services waiting to be published in a batch
+    enum ChangeType {
+        Added,
+        Updated,
+        Removed
+    };
+
+    struct Change
+    {
+        ChangeType type;
+        Service service;
+    };
+
+    // Changes are kept for changesSince(); versions in the log are
+    // consecutive
+    struct LoggedChange
+    {
+        quint64 version;
+        ChangeType type;
+        NameAtom fqName;
+        Service service;
+    };
+
+    static const int MaxLoggedChanges = 1024;
+
+    // Address records for a hostname and the services it provides
+    struct HostState
+    {
+        QSet<NameAtom> services;
+        RecordSet addressRecords;
+        bool queried = false;
+    };
 
     AbstractServer *server;
-    QByteArray _serviceType;
+    int listenerId;
+    NameAtom serviceTypeAtom;
+
+    // Only used to check whether a name is an instance of the service type
+    DomainName serviceTypeName;
+
+    // When browsing for MdnsBrowseType, the service types found are browsed
+    // for as well; otherwise, this only contains the service type
+    bool enumerateTypes;
+    QSet<NameAtom> serviceTypes;
 
     Cache *cache;
-    QMap<QByteArray, Service> _services;
-    QSet<QByteArray> _hostnames;
+    SharedCache *sharedCache;
+    int cacheListenerId;
+    QHash<NameAtom, ServiceState> _states;
+    QHash<NameAtom, HostState> _hosts;
+
+    // Follow-up queries for missing records, sent together
+    QList<QPair<QByteArray, quint16>> pendingQueries;
+
+    // Services currently known, by FQDN, and the history of the changes
+    quint64 version;
+    QMap<QByteArray, Service> services;
+    QList<LoggedChange> changeLog;
+
+    // Batching of the changes (disabled when the interval is negative);
+    // services resolved in the meantime are reported after the batch
+    int batchInterval;
+    QList<NameAtom> pendingOrder;
+    QHash<NameAtom, Change> pendingChanges;
+    QList<NameAtom> pendingResolved;
 
     QTimer queryTimer;
+    QTimer cacheTimer;
+    QTimer followUpTimer;
+    QTimer batchTimer;
+
+    void publishBatch();
+
+    static void mergeChange(QList<NameAtom> &order, QHash<NameAtom, Change> &changes,
+                            ChangeType type, const NameAtom &fqName, const Service &service);
+    static void collectChanges(const QList<NameAtom> &order, const QHash<NameAtom, Change> &changes,
+                               QList<Service> &added, QList<Service> &updated, QList<Service> &removed);
 
 private:
     void onMessageReceived(const Message &message);
-    void onShouldQuery(const Record &record);
+    void onShouldQuery(const QList<Record> &records);
     void onRecordExpired(const Record &record);
+    void loadCachedServices();
     void sendQuery();
 
-    void updateHostnames();
+    bool isInstance(const QByteArray &name) const;
+    void addServiceType(const QByteArray &type);
+    void loadCachedServices(const QByteArray &type);
+
+    ServiceState &state(const NameAtom &fqName);
+    void setSrvRecord(ServiceState &state, const Record &record);
+    void addTxtRecord(ServiceState &state, const Record &record);
+    void updateTxtData(ServiceState &state);
+    void updateService(ServiceState &state);
+    void removeService(ServiceState &state);
+    void publishChange(ChangeType type, const NameAtom &fqName, const Service &service);
+
+    void linkHost(const NameAtom &hostname, const NameAtom &fqName);
+    void unlinkHost(const NameAtom &hostname, const NameAtom &fqName);
+    void addAddressRecord(HostState &host, const Record &record);
+
+    void queueFollowUpQueries(ServiceState &state);
+    void queueQuery(const QByteArray &name, quint16 type);
+    void sendFollowUpQueries();
+
+    void addInterest(const QByteArray &name);
+    void removeInterest(const QByteArray &name);
 
     Browser *const q;
 };
@@ -22,6 +22,11 @@
  * IN THE SOFTWARE.
  */
 
+#include <cstring>
+
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QtEndian>
 #include <QtGlobal>
 #if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
 #include <QRandomGenerator>
@@ -30,13 +35,37 @@
 
 #include <qmdnsengine/cache.h>
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
 
 #include "cache_p.h"
+#include "tracing_p.h"
 
 using namespace QMdnsEngine;
 
-CachePrivate::CachePrivate(Cache *cache)
-    : q(cache)
+// Records are expired when two or more queries go unanswered within this
+// interval; repeated queries (the same query arriving over IPv4 and IPv6,
+// for example) are only counted once per second
+const qint64 FailureWindow = 10 * 1000;
+const qint64 DuplicateQueryInterval = 1000;
+
+// Records of a set being flushed that were received within this interval
+// are kept, since they are part of the new set
+const qint64 FlushInterval = 1000;
+
+// Snapshots begin with a fixed header (the magic, the format version, the
+// size of the header and the number of entries, all big-endian); each entry
+// holds the absolute expiry time in milliseconds since the epoch, the length
+// of the record and the record in wire format, padded to eight bytes
+const char SnapshotMagic[4] = {'Q', 'M', 'D', 'C'};
+const quint16 SnapshotVersion = 1;
+const int SnapshotHeaderSize = 16;
+const int SnapshotEntryHeaderSize = 10;
+const int SnapshotAlignment = 8;
+
+CachePrivate::CachePrivate(Cache *cache, Cache::ConcurrencyMode mode)
+    : mode(mode),
+      q(cache)
 {
     timer.callOnTimeout([this] {
         onTimeout();
@@ -44,41 +73,102 @@ CachePrivate::CachePrivate(Cache *cache)
     timer.setSingleShot(true);
 }
 
+QList<QDateTime> CachePrivate::triggersFor(const QDateTime &start, quint32 ttl)
+{
+    // Add a random offset to the query triggers
+#ifdef USE_QRANDOMGENERATOR
+    qint64 random = QRandomGenerator::global()->bounded(20);
+#else
+    qint64 random = qrand() % 20;
+#endif
+
+    return {
+        start.addMSecs(ttl * 500 + random),  // 50%
+        start.addMSecs(ttl * 850 + random),  // 85%
+        start.addMSecs(ttl * 900 + random),  // 90%
+        start.addMSecs(ttl * 950 + random),  // 95%
+        start.addSecs(ttl)
+    };
+}
+
+CachePrivate::Shard &CachePrivate::shardFor(const NameAtom &atom)
+{
+    // The hash is computed from the canonical name when it is interned, so
+    // the distribution does not depend on where entries are allocated
+    return shards[atom.hash() % ShardCount];
+}
+
+QReadWriteLock *CachePrivate::lockFor(Shard &shard)
+{
+    return mode == Cache::Concurrent ? &shard.lock : nullptr;
+}
+
+QDateTime CachePrivate::nextTime(const Entry &entry) const
+{
+    QDateTime next = entry.triggers.at(0);
+    if (entry.failureDeadline.isValid() && entry.failureDeadline < next) {
+        next = entry.failureDeadline;
+    }
+    return next;
+}
+
+void CachePrivate::scheduleTrigger(const QDateTime &now, const QDateTime &trigger)
+{
+    if (nextTrigger.isNull() || trigger < nextTrigger) {
+        nextTrigger = trigger;
+        timer.start(qMax<qint64>(0, now.msecsTo(nextTrigger)));
+    }
+}
+
 void CachePrivate::onTimeout()
 {
-    // Loop through all of the records in the cache, emitting the appropriate
-    // signal when a trigger has passed, determining when the next trigger
-    // will occur, and removing records that have expired
+    // Loop through all of the records in the cache, determining when the
+    // next trigger will occur and removing records that have expired; the
+    // events are published once no lock is held, since handlers are likely
+    // to look up records
     QDateTime now = QDateTime::currentDateTime();
     QDateTime newNextTrigger;
+    QList<Record> shouldQueryRecords;
+    QList<Record> expiredRecords;
 
-    for (auto i = entries.begin(); i != entries.end();) {
+    for (Shard &shard : shards) {
+        QWriteLocker locker(lockFor(shard));
+        for (auto i = shard.entries.begin(); i != shard.entries.end();) {
 
-        // Loop through the triggers and remove ones that have already
-        // passed
-        bool shouldQuery = false;
-        for (auto j = i->triggers.begin(); j != i->triggers.end();) {
-            if ((*j) <= now) {
-                shouldQuery = true;
-                j = i->triggers.erase(j);
-            } else {
-                break;
+            // Records that went unanswered are removed before their TTL is up
+            if (i->failureDeadline.isValid() && i->failureDeadline <= now) {
+                expiredRecords.append(i->record);
+                i = shard.entries.erase(i);
+                continue;
             }
-        }
 
-        // If triggers remain, determine the next earliest one; if none
-        // remain, the record has expired and should be removed
-        if (i->triggers.length()) {
-            if (newNextTrigger.isNull() || i->triggers.at(0) < newNextTrigger) {
-                newNextTrigger = i->triggers.at(0);
+            // Loop through the triggers and remove ones that have already
+            // passed
+            bool shouldQuery = false;
+            for (auto j = i->triggers.begin(); j != i->triggers.end();) {
+                if ((*j) <= now) {
+                    shouldQuery = true;
+                    j = i->triggers.erase(j);
+                } else {
+                    break;
+                }
             }
-            if (shouldQuery) {
-                q->publish(ShouldQuery{i->record});
+
+            // If triggers remain, determine the next earliest one; if none
+            // remain, the record has expired and should be removed
+            if (i->triggers.length()) {
+                QDateTime next = nextTime(*i);
+                if (newNextTrigger.isNull() || next < newNextTrigger) {
+                    newNextTrigger = next;
+                }
+                if (shouldQuery) {
+                    shouldQueryRecords.append(i->record);
+                }
+                ++i;
+            } else {
+                expiredRecords.append(i->record);
+                i = shard.entries.erase(i);
             }
-            ++i;
-        } else {
-            q->publish(RecordExpired{i->record});
-            i = entries.erase(i);
         }
     }
 
@@ -88,62 +178,141 @@ void CachePrivate::onTimeout()
     if (!nextTrigger.isNull()) {
         timer.start(now.msecsTo(nextTrigger));
     }
+
+    expirations += expiredRecords.length();
+    for (const Record &record : expiredRecords) {
+        q->publish(RecordExpired{record});
+    }
+
+    // Report all of the records that should be queried at once
+    if (!shouldQueryRecords.isEmpty()) {
+        q->publish(ShouldQuery{shouldQueryRecords});
+    }
 }
 
-Cache::Cache()
-    : d(new CachePrivate(this)) {
+Cache::Cache(ConcurrencyMode mode)
+    : d(new CachePrivate(this, mode)) {
 }
 
 void Cache::addRecord(const Record &record)
 {
-    // If a record exists that matches, remove it from the cache; if the TTL
-    // is nonzero, it will be added back to the cache with updated times
-    for (auto i = d->entries.begin(); i != d->entries.end();) {
-        if ((record.flushCache() &&
-                (*i).record.name() == record.name() &&
-                (*i).record.type() == record.type()) ||
-                (*i).record == record) {
-
-            // If the TTL is set to 0, indicate that the record was removed
-            if (record.ttl() == 0) {
-                publish(RecordExpired{(*i).record});
-            }
+    QMDNSENGINE_TRACE(TraceCacheUpdate);
+
+    QDateTime now = QDateTime::currentDateTime();
+    QList<Record> expiredRecords;
+
+    {
+        CachePrivate::Shard &shard = d->shardFor(record.nameAtom());
+        QWriteLocker locker(d->lockFor(shard));
+
+        // If a record exists that matches, remove it from the cache; if the
+        // TTL is nonzero, it will be added back to the cache with updated
+        // times
+        for (auto i = shard.entries.begin(); i != shard.entries.end();) {
+            if ((*i).record != record && record.flushCache() && record.ttl() != 0 &&
+                    (*i).record.nameAtom() == record.nameAtom() &&
+                    (*i).record.type() == record.type()) {
+
+                // Other records of a set being flushed are not removed right
+                // away: those received in the last second belong to the new
+                // set (they often arrive in the same packet) and the others
+                // expire in one second (RFC 6762, section 10.2)
+                if ((*i).received.msecsTo(now) > FlushInterval &&
+                        (*i).triggers.last() > now.addMSecs(FlushInterval)) {
+                    (*i).triggers = {now.addMSecs(FlushInterval)};
+                    d->scheduleTrigger(now, (*i).triggers.at(0));
+                }
+                ++i;
+            } else if ((record.flushCache() &&
+                    (*i).record.nameAtom() == record.nameAtom() &&
+                    (*i).record.type() == record.type()) ||
+                    (*i).record == record) {
+
+                // If the TTL is set to 0, indicate that the record was removed
+                if (record.ttl() == 0) {
+                    expiredRecords.append((*i).record);
+                }
 
-            i = d->entries.erase(i);
+                i = shard.entries.erase(i);
 
-            // No need to continue further if the TTL was set to 0
-            if (record.ttl() == 0) {
-                return;
+                // No need to continue further if the TTL was set to 0
+                if (record.ttl() == 0) {
+                    break;
+                }
+            } else {
+                ++i;
             }
-        } else {
-            ++i;
+        }
+
+        if (expiredRecords.isEmpty()) {
+
+            // Use the current time to calculate the triggers and append the
+            // record
+            CachePrivate::Entry entry;
+            entry.record = record;
+            entry.triggers = CachePrivate::triggersFor(now, record.ttl());
+            entry.received = now;
+            shard.entries.append(entry);
+            ++d->insertions;
+
+            // Check if the new record's first trigger is earlier than the
+            // next scheduled trigger; if so, restart the timer
+            d->scheduleTrigger(now, entry.triggers.at(0));
         }
     }
 
-    // Use the current time to calculate the triggers and add a random offset
+    d->expirations += expiredRecords.length();
+    for (const Record &expiredRecord : expiredRecords) {
+        publish(RecordExpired{expiredRecord});
+    }
+}
+
+void Cache::observeQuery(const Message &message)
+{
+    if (message.isResponse()) {
+        return;
+    }
+
     QDateTime now = QDateTime::currentDateTime();
-#ifdef USE_QRANDOMGENERATOR
-    qint64 random = QRandomGenerator::global()->bounded(20);
-#else
-    qint64 random = qrand() % 20;
-#endif
+    const auto queries = message.queries();
+    const auto knownAnswers = message.records();
+    for (CachePrivate::Shard &shard : d->shards) {
+        QWriteLocker locker(d->lockFor(shard));
+        for (CachePrivate::Entry &entry : shard.entries) {
 
-    QList<QDateTime> triggers{
-        now.addMSecs(record.ttl() * 500 + random),  // 50%
-        now.addMSecs(record.ttl() * 850 + random),  // 85%
-        now.addMSecs(record.ttl() * 900 + random),  // 90%
-        now.addMSecs(record.ttl() * 950 + random),  // 95%
-        now.addSecs(record.ttl())
-    };
+            // Determine if the record answers any of the queries; if the
+            // querier already knows it, no response is expected
+            bool answers = false;
+            for (const Query &query : queries) {
+                if (query.nameAtom() == entry.record.nameAtom() &&
+                        (query.type() == ANY || query.type() == entry.record.type())) {
+                    answers = true;
+                    break;
+                }
+            }
+            if (!answers || knownAnswers.contains(entry.record)) {
+                continue;
+            }
+            if (entry.lastQuery.isValid() && entry.lastQuery.msecsTo(now) < DuplicateQueryInterval) {
+                continue;
+            }
+            entry.lastQuery = now;
 
-    // Append the record and its triggers
-    d->entries.append({record, triggers});
+            // Count the queries within the window starting with the first one
+            if (entry.firstQuery.isNull() || entry.firstQuery.msecsTo(now) > FailureWindow) {
+                entry.firstQuery = now;
+                entry.unansweredQueries = 0;
+            }
+            ++entry.unansweredQueries;
 
-    // Check if the new record's first trigger is earlier than the next
-    // scheduled trigger; if so, restart the timer
-    if (d->nextTrigger.isNull() || triggers.at(0) < d->nextTrigger) {
-        d->nextTrigger = triggers.at(0);
-        d->timer.start(now.msecsTo(d->nextTrigger));
+            // Once the record is queried twice, it is expired at the end of
+            // the window unless a response refreshes it (which replaces the
+            // entry)
+            if (entry.unansweredQueries == 2) {
+                entry.failureDeadline = entry.firstQuery.addMSecs(FailureWindow);
+                d->scheduleTrigger(now, entry.failureDeadline);
+            }
+        }
     }
 }
 
@@ -159,13 +328,234 @@ bool Cache::lookupRecord(const QByteArray &name, quint16 type, Record &record) c
 
 bool Cache::lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const
 {
+    // A name that was never interned cannot belong to any record
+    NameAtom atom = NameAtom::find(name);
+    if (!name.isNull() && atom.isNull()) {
+        ++d->misses;
+        return false;
+    }
+
+    // Only the shard containing the name needs to be searched
+    bool recordsAdded = false;
+    for (CachePrivate::Shard &shard : d->shards) {
+        if (!atom.isNull() && &shard != &d->shardFor(atom)) {
+            continue;
+        }
+        QReadLocker locker(d->lockFor(shard));
+        for (const CachePrivate::Entry &entry : shard.entries) {
+            if ((atom.isNull() || entry.record.nameAtom() == atom) &&
+                    (type == ANY || entry.record.type() == type)) {
+                records.append(entry.record);
+                recordsAdded = true;
+            }
+        }
+    }
+    if (recordsAdded) {
+        ++d->hits;
+    } else {
+        ++d->misses;
+    }
+    return recordsAdded;
+}
+
+bool Cache::lookupKnownAnswers(const QByteArray &name, quint16 type, QList<Record> &records) const
+{
+    NameAtom atom = NameAtom::find(name);
+    if (atom.isNull()) {
+        return false;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
     bool recordsAdded = false;
-    for (const CachePrivate::Entry &entry : d->entries) {
-        if ((name.isNull() || entry.record.name() == name) &&
+    CachePrivate::Shard &shard = d->shardFor(atom);
+    QReadLocker locker(d->lockFor(shard));
+    for (const CachePrivate::Entry &entry : shard.entries) {
+        if (entry.record.nameAtom() == atom &&
                 (type == ANY || entry.record.type() == type)) {
-            records.append(entry.record);
-            recordsAdded = true;
+            qint64 remaining = now.secsTo(entry.triggers.last());
+            if (remaining * 2 > entry.record.ttl()) {
+                Record record = entry.record;
+                record.setTtl(remaining);
+                records.append(record);
+                recordsAdded = true;
+            }
         }
     }
     return recordsAdded;
 }
+
+bool Cache::hasNegativeEntry(const QByteArray &name, quint16 type) const
+{
+    NameAtom atom = NameAtom::find(name);
+    if (atom.isNull()) {
+        return false;
+    }
+
+    bool negative = false;
+    CachePrivate::Shard &shard = d->shardFor(atom);
+    QReadLocker locker(d->lockFor(shard));
+    for (const CachePrivate::Entry &entry : shard.entries) {
+        if (entry.record.nameAtom() != atom) {
+            continue;
+        }
+        if (entry.record.type() == type) {
+            return false;
+        }
+        if (entry.record.type() == NSEC && !entry.record.bitmap().testBit(type)) {
+            negative = true;
+        }
+    }
+    return negative;
+}
+
+void Cache::removeRecords(const QByteArray &name, quint16 type)
+{
+    NameAtom atom = NameAtom::find(name);
+    if (atom.isNull()) {
+        return;
+    }
+    CachePrivate::Shard &shard = d->shardFor(atom);
+    QWriteLocker locker(d->lockFor(shard));
+    for (auto i = shard.entries.begin(); i != shard.entries.end();) {
+        if ((*i).record.nameAtom() == atom && (type == ANY || (*i).record.type() == type)) {
+            i = shard.entries.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+QByteArray Cache::saveSnapshot() const
+{
+    QByteArray snapshot(SnapshotHeaderSize, '\0');
+    memcpy(snapshot.data(), SnapshotMagic, sizeof(SnapshotMagic));
+    qToBigEndian<quint16>(SnapshotVersion, snapshot.data() + 4);
+    qToBigEndian<quint16>(SnapshotHeaderSize, snapshot.data() + 6);
+
+    quint32 count = 0;
+    for (CachePrivate::Shard &shard : d->shards) {
+        QReadLocker locker(d->lockFor(shard));
+        for (const CachePrivate::Entry &entry : shard.entries) {
+
+            // Each record is written on its own (without name compression)
+            // so that it can be parsed independently of the others
+            QByteArray data;
+            quint16 offset = 0;
+            QMap<QByteArray, quint16> nameMap;
+            Record record = entry.record;
+            writeRecord(data, offset, record, nameMap);
+
+            // The length is stored in 16 bits; larger records are left out
+            // rather than making the whole snapshot unreadable
+            if (data.length() > 0xffff) {
+                continue;
+            }
+
+            char header[SnapshotEntryHeaderSize];
+            qToBigEndian<qint64>(entry.triggers.last().toMSecsSinceEpoch(), header);
+            qToBigEndian<quint16>(data.length(), header + 8);
+            snapshot.append(header, SnapshotEntryHeaderSize);
+            snapshot.append(data);
+
+            int padding = (SnapshotAlignment - snapshot.length() % SnapshotAlignment) % SnapshotAlignment;
+            snapshot.append(QByteArray(padding, '\0'));
+            ++count;
+        }
+    }
+    qToBigEndian<quint32>(count, snapshot.data() + 8);
+
+    return snapshot;
+}
+
+bool Cache::loadSnapshot(const QByteArray &snapshot)
+{
+    const char *data = snapshot.constData();
+    if (snapshot.length() < SnapshotHeaderSize ||
+            memcmp(data, SnapshotMagic, sizeof(SnapshotMagic)) != 0 ||
+            qFromBigEndian<quint16>(data + 4) != SnapshotVersion) {
+        return false;
+    }
+    int headerSize = qFromBigEndian<quint16>(data + 6);
+    quint32 count = qFromBigEndian<quint32>(data + 8);
+    if (headerSize < SnapshotHeaderSize || headerSize > snapshot.length()) {
+        return false;
+    }
+
+    // Parse all of the entries before modifying the cache so that a corrupt
+    // snapshot leaves it untouched
+    QDateTime now = QDateTime::currentDateTime();
+    qint64 nowMs = now.toMSecsSinceEpoch();
+    QList<CachePrivate::Entry> loaded;
+    int offset = headerSize;
+    for (quint32 i = 0; i < count; ++i) {
+        if (snapshot.length() - offset < SnapshotEntryHeaderSize) {
+            return false;
+        }
+        qint64 expiry = qFromBigEndian<qint64>(data + offset);
+        int length = qFromBigEndian<quint16>(data + offset + 8);
+        offset += SnapshotEntryHeaderSize;
+        if (snapshot.length() - offset < length) {
+            return false;
+        }
+
+        // The record is parsed in place (the snapshot may be a mapped file)
+        // and the parser copies whatever it keeps
+        QByteArray recordData = QByteArray::fromRawData(data + offset, length);
+        quint16 recordOffset = 0;
+        Record record;
+        if (!parseRecord(recordData, recordOffset, record) || recordOffset != length) {
+            return false;
+        }
+        offset += length;
+        offset += (SnapshotAlignment - offset % SnapshotAlignment) % SnapshotAlignment;
+
+        // Drop records that expired while the snapshot was stored
+        if (expiry <= nowMs) {
+            continue;
+        }
+
+        // Rebuild the triggers from the time the record was received; those
+        // that have already passed are dropped, except for the expiry
+        CachePrivate::Entry entry;
+        entry.record = record;
+        entry.received = QDateTime::fromMSecsSinceEpoch(expiry - record.ttl() * 1000ll);
+        entry.triggers = CachePrivate::triggersFor(entry.received, record.ttl());
+        entry.triggers.last() = QDateTime::fromMSecsSinceEpoch(expiry);
+        while (entry.triggers.length() > 1 && entry.triggers.at(0) <= now) {
+            entry.triggers.removeFirst();
+        }
+        loaded.append(entry);
+    }
+
+    for (const CachePrivate::Entry &entry : loaded) {
+        CachePrivate::Shard &shard = d->shardFor(entry.record.nameAtom());
+        QWriteLocker locker(d->lockFor(shard));
+        for (auto i = shard.entries.begin(); i != shard.entries.end();) {
+            if ((*i).record == entry.record) {
+                i = shard.entries.erase(i);
+            } else {
+                ++i;
+            }
+        }
+        shard.entries.append(entry);
+        ++d->insertions;
+        d->scheduleTrigger(now, entry.triggers.at(0));
+    }
+
+    return true;
+}
+
+CacheStatistics Cache::statistics() const
+{
+    CacheStatistics statistics;
+    statistics.size = 0;
+    for (CachePrivate::Shard &shard : d->shards) {
+        QReadLocker locker(d->lockFor(shard));
+        statistics.size += shard.entries.size();
+    }
+    statistics.hits = d->hits;
+    statistics.misses = d->misses;
+    statistics.insertions = d->insertions;
+    statistics.expirations = d->expirations;
+    return statistics;
+}
@@ -25,18 +25,22 @@
 #ifndef QMDNSENGINE_CACHE_P_H
 #define QMDNSENGINE_CACHE_P_H
 
+#include <atomic>
+
 #include <QDateTime>
 #include <QList>
 #include <QObject>
+#include <QReadWriteLock>
 #include <QTimer>
 
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/nameatom.h>
 #include <qmdnsengine/record.h>
+#include <qmdnsengine/statistics.h>
 
 namespace QMdnsEngine
 {
 
-class Cache;
-
 class CachePrivate
 {
 public:
@@ -45,14 +49,52 @@ public:
     {
         Record record;
         QList<QDateTime> triggers;
+        QDateTime received;
+
+        // Queries observed that the record would answer (for passive
+        // observation of failures, RFC 6762, section 10.5)
+        QDateTime firstQuery;
+        QDateTime lastQuery;
+        int unansweredQueries = 0;
+        QDateTime failureDeadline;
     };
 
-    CachePrivate(Cache *cache);
+    // Entries are distributed among shards by name so that a writer only
+    // locks the shard containing the name it updates
+    struct Shard
+    {
+        QReadWriteLock lock;
+        QList<Entry> entries;
+    };
+
+    static constexpr int ShardCount = 16;
+
+    CachePrivate(Cache *cache, Cache::ConcurrencyMode mode);
 
+    static QList<QDateTime> triggersFor(const QDateTime &start, quint32 ttl);
+
+    Shard &shardFor(const NameAtom &atom);
+
+    // Locks are only used in concurrent mode (QReadLocker and QWriteLocker
+    // do nothing when given a null lock)
+    QReadWriteLock *lockFor(Shard &shard);
+
+    QDateTime nextTime(const Entry &entry) const;
+    void scheduleTrigger(const QDateTime &now, const QDateTime &trigger);
+
+    const Cache::ConcurrencyMode mode;
+    Shard shards[ShardCount];
+
+    // Only used by the thread the cache belongs to
     QTimer timer;
-    QList<Entry> entries;
     QDateTime nextTrigger;
 
+    // Counters for lookups are updated by const methods, from any thread
+    std::atomic<quint64> hits{0};
+    std::atomic<quint64> misses{0};
+    std::atomic<quint64> insertions{0};
+    std::atomic<quint64> expirations{0};
+
 private:
     void onTimeout();
 
@@ -31,6 +31,8 @@
 #include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
+#include "tracing_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -165,21 +167,18 @@ bool parseRecord(const QByteArray &packet, std::uint16_t &offset, Record &record
     }
     case NSEC:
     {
+        int end = offset + dataLen;
         QByteArray nextDomainName;
-        std::uint8_t number;
-        std::uint8_t length;
-        if (!parseName(packet, offset, nextDomainName) ||
-                !parseInteger<std::uint8_t>(packet, offset, number) ||
-                !parseInteger<std::uint8_t>(packet, offset, length) ||
-                number != 0 ||
-                offset + length > packet.length()) {
+        Bitmap bitmap;
+        if (end > packet.length() ||
+                !parseName(packet, offset, nextDomainName) ||
+                offset > end ||
+                !bitmap.fromWire(packet.constData() + offset, end - offset)) {
             return false;
         }
-        Bitmap bitmap;
-        bitmap.setData(length, reinterpret_cast<const std::uint8_t*>(packet.constData() + offset));
         record.setNextDomainName(nextDomainName);
         record.setBitmap(bitmap);
-        offset += length;
+        offset = end;
         break;
     }
     case PTR:
@@ -209,25 +208,26 @@ bool parseRecord(const QByteArray &packet, std::uint16_t &offset, Record &record
     }
     case TXT:
     {
-        std::uint16_t start = offset;
-        while (offset < start + dataLen) {
-            std::uint8_t nBytes;
-            if (!parseInteger<std::uint8_t>(packet, offset, nBytes) ||
-                    offset + nBytes > packet.length()) {
+        // Only validate the strings here; they are split into attributes
+        // when the attributes are first requested
+        int end = offset + dataLen;
+        if (end > packet.length()) {
+            return false;
+        }
+        for (int i = offset; i < end; i += 1 + static_cast<std::uint8_t>(packet.at(i))) {
+            if (i + 1 + static_cast<std::uint8_t>(packet.at(i)) > end) {
                 return false;
             }
-            if (nBytes == 0) {
-                break;
-            }
-            QByteArray attr(packet.constData() + offset, nBytes);
-            offset += nBytes;
-            int splitIndex = attr.indexOf('=');
-            if (splitIndex == -1) {
-                record.addAttribute(attr, QByteArray());
-            } else {
-                record.addAttribute(attr.left(splitIndex), attr.mid(splitIndex + 1));
-            }
         }
+
+        // A single empty string is how a TXT record without attributes is
+        // written, so store it as empty data
+        if (dataLen == 1 && packet.at(offset) == 0) {
+            record.setTxtData(QByteArray());
+        } else {
+            record.setTxtData(packet.mid(offset, dataLen));
+        }
+        offset = end;
         break;
     }
     default:
@@ -258,12 +258,10 @@ void writeRecord(QByteArray &packet, std::uint16_t &offset, Record &record, QMap
     }
     case NSEC:
     {
-        std::uint8_t length = record.bitmap().length();
+        Bitmap bitmap = record.bitmap();
         writeName(data, offset, record.nextDomainName(), nameMap);
-        writeInteger<std::uint8_t>(data, offset, 0);
-        writeInteger<std::uint8_t>(data, offset, length);
-        data.append(reinterpret_cast<const char*>(record.bitmap().data()), length);
-        offset += length;
+        bitmap.toWire(data);
+        offset += bitmap.wireLength();
         break;
     }
     case PTR:
@@ -276,17 +274,16 @@ void writeRecord(QByteArray &packet, std::uint16_t &offset, Record &record, QMap
         writeName(data, offset, record.target(), nameMap);
         break;
     case TXT:
-        if (!record.attributes().count()) {
+    {
+        QByteArray txtData = record.txtData();
+        if (txtData.isEmpty()) {
             writeInteger<std::uint8_t>(data, offset, 0);
             break;
         }
-        for (auto i = record.attributes().constBegin(); i != record.attributes().constEnd(); ++i) {
-            QByteArray entry = i.value().isNull() ? i.key() : i.key() + "=" + i.value();
-            writeInteger<std::uint8_t>(data, offset, entry.length());
-            data.append(entry);
-            offset += entry.length();
-        }
+        data.append(txtData);
+        offset += txtData.length();
         break;
+    }
     default:
         break;
     }
@@ -296,7 +293,15 @@ void writeRecord(QByteArray &packet, std::uint16_t &offset, Record &record, QMap
 }
 
 std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress& address, std::uint16_t port) {
+    ParseError error;
+    return fromPacket(packet, address, port, error);
+}
+
+std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress& address, std::uint16_t port, ParseError &error) {
+    QMDNSENGINE_TRACE(TraceDecode);
+
     if (packet.size() < 12) {
+        error = TruncatedHeader;
         return {};
     }
 
@@ -322,6 +327,7 @@ std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress&
         if (!parseName(packet, offset, name) ||
             !parseInteger<std::uint16_t>(packet, offset, type) ||
             !parseInteger<std::uint16_t>(packet, offset, class_)) {
+            error = InvalidQuery;
             return {};
         }
         Query query;
@@ -334,19 +340,36 @@ std::optional<Message> fromPacket(const QByteArray &packet, const QHostAddress&
     for (int i = 0; i < nRecord; ++i) {
         Record record;
         if (!parseRecord(packet, offset, record)) {
+            if (i < answerCount) {
+                error = InvalidAnswer;
+            } else if (i < answerCount + authorityCount) {
+                error = InvalidAuthority;
+            } else {
+                error = InvalidAdditional;
+            }
             return {};
         }
-        message.addRecord(record);
+
+        // Records in the authority section describe what a probing host
+        // intends to claim and must not be mistaken for answers
+        if (i >= answerCount && i < answerCount + authorityCount) {
+            message.addAuthorityRecord(record);
+        } else {
+            message.addRecord(record);
+        }
     }
 
     message.setAddress(address);
     message.setPort(port);
 
+    error = NoParseError;
     return message;
 }
 
 void toPacket(const Message &message, QByteArray &packet)
 {
+    QMDNSENGINE_TRACE(TraceEncode);
+
     std::uint16_t offset = 0;
     std::uint16_t flags = (message.isResponse() ? 0x8400 : 0) |
         (message.isTruncated() ? 0x200 : 0);
@@ -354,7 +377,7 @@ void toPacket(const Message &message, QByteArray &packet)
     writeInteger<std::uint16_t>(packet, offset, flags);
     writeInteger<std::uint16_t>(packet, offset, message.queries().size());
     writeInteger<std::uint16_t>(packet, offset, message.records().size());
-    writeInteger<std::uint16_t>(packet, offset, 0);
+    writeInteger<std::uint16_t>(packet, offset, message.authorityRecords().size());
     writeInteger<std::uint16_t>(packet, offset, 0);
     QMap<QByteArray, std::uint16_t> nameMap;
     const auto queries = message.queries();
@@ -367,6 +390,51 @@ void toPacket(const Message &message, QByteArray &packet)
     for (Record record : records) {
         writeRecord(packet, offset, record, nameMap);
     }
+    const auto authorityRecords = message.authorityRecords();
+    for (Record record : authorityRecords) {
+        writeRecord(packet, offset, record, nameMap);
+    }
+}
+
+// Names are written as a series of length-prefixed labels followed by a
+// terminating zero; without compression that is at most two bytes more than
+// the dotted representation
+static int nameSize(const QByteArray &name)
+{
+    return name.length() + 2;
+}
+
+int querySize(const Query &query)
+{
+    return nameSize(query.name()) + 4;
+}
+
+int recordSize(const Record &record)
+{
+    int size = nameSize(record.name()) + 10;
+    switch (record.type()) {
+    case A:
+        size += 4;
+        break;
+    case AAAA:
+        size += 16;
+        break;
+    case NSEC:
+        size += nameSize(record.nextDomainName()) + record.bitmap().wireLength();
+        break;
+    case PTR:
+        size += nameSize(record.target());
+        break;
+    case SRV:
+        size += 6 + nameSize(record.target());
+        break;
+    case TXT:
+        size += qMax(record.txtData().length(), 1);
+        break;
+    default:
+        break;
+    }
+    return size;
 }
 
 QString typeName(std::uint16_t type)
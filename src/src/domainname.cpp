@@ -0,0 +1,364 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QSharedData>
+#include <QVarLengthArray>
+
+#include <qmdnsengine/domainname.h>
+
+namespace QMdnsEngine
+{
+
+struct DomainNameData : public QSharedData
+{
+    // Wire format of the complete name
+    QByteArray wire;
+
+    // Offset of each label in the wire format, including the final
+    // zero-length label, and the hash of the suffix starting there
+    QVarLengthArray<quint8, 16> offsets;
+    QVarLengthArray<uint, 16> hashes;
+};
+
+}
+
+using namespace QMdnsEngine;
+
+namespace
+{
+
+const int MaxLabelLength = 63;
+const int MaxNameLength = 255;
+
+inline char toLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+bool equalsIgnoreCase(const char *a, const char *b, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        if (a[i] != b[i] && toLower(a[i]) != toLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Determine if a name in text form (without the trailing ".") has a label
+// that is empty
+bool hasEmptyLabel(const char *name, int length)
+{
+    if (!length || name[0] == '.' || name[length - 1] == '.') {
+        return true;
+    }
+    for (int i = 1; i < length; ++i) {
+        if (name[i] == '.' && name[i - 1] == '.') {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Length bytes are never letters, so the label is hashed along with its
+// length (FNV-1a)
+uint hashLabel(uint hash, const char *label)
+{
+    int length = static_cast<quint8>(label[0]);
+    for (int i = 0; i <= length; ++i) {
+        hash ^= static_cast<quint8>(toLower(label[i]));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// The wire format must already have been validated
+DomainNameData *createData(const QByteArray &wire)
+{
+    DomainNameData *data = new DomainNameData;
+    data->wire = wire;
+    for (int offset = 0;;) {
+        data->offsets.append(offset);
+        int length = static_cast<quint8>(wire.at(offset));
+        if (!length) {
+            break;
+        }
+        offset += length + 1;
+    }
+
+    // Hash the suffixes starting with the rightmost label
+    int count = data->offsets.size();
+    data->hashes.resize(count);
+    uint hash = 2166136261u;
+    data->hashes[count - 1] = hash;
+    for (int i = count - 2; i >= 0; --i) {
+        hash = hashLabel(hash, wire.constData() + data->offsets.at(i));
+        data->hashes[i] = hash;
+    }
+    return data;
+}
+
+}
+
+DomainName::DomainName()
+    : first(0)
+{
+}
+
+DomainName::DomainName(const QByteArray &name)
+    : first(0)
+{
+    if (name.isNull()) {
+        return;
+    }
+
+    // Ignore a single trailing "." (and treat "." as the root name)
+    int length = name.length();
+    if (length && name.at(length - 1) == '.') {
+        --length;
+    }
+
+    QByteArray wire;
+    wire.reserve(length + 2);
+    int start = 0;
+    while (start < length) {
+        int end = name.indexOf('.', start);
+        if (end < 0 || end > length) {
+            end = length;
+        }
+        int labelLength = end - start;
+        if (labelLength == 0 || labelLength > MaxLabelLength) {
+            return;
+        }
+        wire.append(static_cast<char>(labelLength));
+        wire.append(name.constData() + start, labelLength);
+        start = end + 1;
+    }
+
+    // Stopping exactly at the end means that the name ended with ".."
+    if (length && start == length) {
+        return;
+    }
+    wire.append('\0');
+    if (wire.length() > MaxNameLength) {
+        return;
+    }
+    d = QExplicitlySharedDataPointer<DomainNameData>(createData(wire));
+}
+
+DomainName::DomainName(const DomainName &other)
+    : d(other.d),
+      first(other.first)
+{
+}
+
+DomainName &DomainName::operator=(const DomainName &other)
+{
+    d = other.d;
+    first = other.first;
+    return *this;
+}
+
+DomainName::~DomainName()
+{
+}
+
+DomainName DomainName::fromWire(const QByteArray &wire)
+{
+    DomainName name;
+    if (wire.length() > MaxNameLength) {
+        return name;
+    }
+    for (int offset = 0; offset < wire.length();) {
+        int length = static_cast<quint8>(wire.at(offset));
+        if (!length) {
+            if (offset == wire.length() - 1) {
+                name.d = QExplicitlySharedDataPointer<DomainNameData>(createData(wire));
+            }
+            break;
+        }
+
+        // This also rejects compression pointers
+        if (length > MaxLabelLength) {
+            break;
+        }
+        offset += length + 1;
+    }
+    return name;
+}
+
+bool DomainName::isNull() const
+{
+    return !d;
+}
+
+bool DomainName::isRoot() const
+{
+    return d && labelCount() == 0;
+}
+
+int DomainName::labelCount() const
+{
+    return d ? d->offsets.size() - 1 - first : 0;
+}
+
+QByteArray DomainName::label(int index) const
+{
+    if (index < 0 || index >= labelCount()) {
+        return QByteArray();
+    }
+    int offset = d->offsets.at(first + index);
+    return d->wire.mid(offset + 1, static_cast<quint8>(d->wire.at(offset)));
+}
+
+DomainName DomainName::parent() const
+{
+    if (!labelCount()) {
+        return DomainName();
+    }
+    DomainName name(*this);
+    ++name.first;
+    return name;
+}
+
+bool DomainName::isSubdomainOf(const DomainName &other) const
+{
+    if (!d || !other.d) {
+        return false;
+    }
+    int skip = labelCount() - other.labelCount();
+    if (skip <= 0) {
+        return false;
+    }
+    int offset = d->offsets.at(first + skip);
+    int otherOffset = other.d->offsets.at(other.first);
+    int length = d->wire.length() - offset;
+    return d->hashes.at(first + skip) == other.d->hashes.at(other.first) &&
+            length == other.d->wire.length() - otherOffset &&
+            equalsIgnoreCase(d->wire.constData() + offset, other.d->wire.constData() + otherOffset, length);
+}
+
+bool DomainName::matches(const QByteArray &name) const
+{
+    if (!d) {
+        return false;
+    }
+    int length = name.length();
+    if (length && name.at(length - 1) == '.') {
+        --length;
+    }
+    return compareText(name.constData(), length);
+}
+
+bool DomainName::isParentOf(const QByteArray &name) const
+{
+    if (!d) {
+        return false;
+    }
+    int length = name.length();
+    if (length && name.at(length - 1) == '.') {
+        --length;
+    }
+    if (isRoot()) {
+        return length > 0 && !hasEmptyLabel(name.constData(), length);
+    }
+
+    // Length of this name in text form without the trailing "."
+    int suffixLength = d->wire.length() - d->offsets.at(first) - 2;
+    int prefixLength = length - suffixLength - 1;
+    if (prefixLength <= 0 || name.at(prefixLength) != '.' ||
+            hasEmptyLabel(name.constData(), prefixLength)) {
+        return false;
+    }
+    return compareText(name.constData() + length - suffixLength, suffixLength);
+}
+
+QByteArray DomainName::toByteArray() const
+{
+    if (!d) {
+        return QByteArray();
+    }
+    if (isRoot()) {
+        return QByteArray(".");
+    }
+    QByteArray name;
+    name.reserve(d->wire.length() - d->offsets.at(first));
+    for (int i = first; i < d->offsets.size() - 1; ++i) {
+        int offset = d->offsets.at(i);
+        name.append(d->wire.constData() + offset + 1, static_cast<quint8>(d->wire.at(offset)));
+        name.append('.');
+    }
+    return name;
+}
+
+QByteArray DomainName::toWire() const
+{
+    if (!d) {
+        return QByteArray();
+    }
+    return first ? d->wire.mid(d->offsets.at(first)) : d->wire;
+}
+
+uint DomainName::hash() const
+{
+    return d ? d->hashes.at(first) : 0;
+}
+
+bool DomainName::operator==(const DomainName &other) const
+{
+    if (d == other.d && first == other.first) {
+        return true;
+    }
+    if (!d || !other.d) {
+        return false;
+    }
+    int offset = d->offsets.at(first);
+    int otherOffset = other.d->offsets.at(other.first);
+    int length = d->wire.length() - offset;
+    return d->hashes.at(first) == other.d->hashes.at(other.first) &&
+            length == other.d->wire.length() - otherOffset &&
+            equalsIgnoreCase(d->wire.constData() + offset, other.d->wire.constData() + otherOffset, length);
+}
+
+bool DomainName::compareText(const char *name, int length) const
+{
+    const char *wire = d->wire.constData();
+    int position = 0;
+    for (int i = first; i < d->offsets.size() - 1; ++i) {
+        if (i != first) {
+            if (position >= length || name[position] != '.') {
+                return false;
+            }
+            ++position;
+        }
+        int offset = d->offsets.at(i);
+        int labelLength = static_cast<quint8>(wire[offset]);
+        if (length - position < labelLength ||
+                !equalsIgnoreCase(wire + offset + 1, name + position, labelLength)) {
+            return false;
+        }
+        position += labelLength;
+    }
+    return position == length;
+}
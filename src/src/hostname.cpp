@@ -28,23 +28,27 @@
 #include <QNetworkInterface>
 
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/bitmap.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
+#include "announcer_p.h"
 #include "hostname_p.h"
+#include "tracing_p.h"
 
 using namespace QMdnsEngine;
 
 HostnamePrivate::HostnamePrivate(Hostname *hostname, AbstractServer *server)
     : QObject(hostname),
       server(server),
+      announcer(Announcer::acquire(server)),
       q(hostname) {
 
-    server->on<MessageReceived>([this](const MessageReceived& event, const AbstractServer&) {
-        onMessageReceived(event.message);
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
     });
 
     connect(&registrationTimer, &QTimer::timeout, this, &HostnamePrivate::onRegistrationTimeout);
@@ -60,6 +64,15 @@ HostnamePrivate::HostnamePrivate(Hostname *hostname, AbstractServer *server)
     onRebroadcastTimeout();
 }
 
+HostnamePrivate::~HostnamePrivate()
+{
+    server->removeMessageListener(listenerId);
+    if (!announcedRecords.isEmpty()) {
+        announcer->goodbye(announcedRecords);
+    }
+    Announcer::release(announcer);
+}
+
 void HostnamePrivate::assertHostname()
 {
     // Begin with the local hostname and replace any "." with "-" (I'm looking
@@ -71,6 +84,7 @@ void HostnamePrivate::assertHostname()
     // aid in finding one that is unique and not in use
     hostname = (hostnameSuffix == 1 ? localHostname:
         localHostname + "-" + QByteArray::number(hostnameSuffix)) + ".local.";
+    hostnameAtom = NameAtom(hostname);
 
     // Compose a query for A and AAAA records matching the hostname
     Query ipv4Query;
@@ -115,6 +129,51 @@ bool HostnamePrivate::generateRecord(const QHostAddress &srcAddress, quint16 typ
     return false;
 }
 
+Record HostnamePrivate::generateNsecRecord(const QHostAddress &srcAddress)
+{
+    Bitmap bitmap;
+    Record record;
+    if (generateRecord(srcAddress, A, record)) {
+        bitmap.setBit(A);
+    }
+    if (generateRecord(srcAddress, AAAA, record)) {
+        bitmap.setBit(AAAA);
+    }
+
+    Record nsecRecord;
+    nsecRecord.setName(hostname);
+    nsecRecord.setType(NSEC);
+    nsecRecord.setFlushCache(true);
+    nsecRecord.setNextDomainName(hostname);
+    nsecRecord.setBitmap(bitmap);
+    return nsecRecord;
+}
+
+QList<Record> HostnamePrivate::generateRecords() const
+{
+    // Create a record for each address on the interfaces that are up, which
+    // is what gets announced once the hostname is registered
+
+    QList<Record> records;
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if (!(networkInterface.flags() & QNetworkInterface::IsUp) ||
+                networkInterface.flags() & QNetworkInterface::IsLoopBack) {
+            continue;
+        }
+        const auto entries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &entry : entries) {
+            Record record;
+            record.setName(hostname);
+            record.setType(entry.ip().protocol() == QAbstractSocket::IPv4Protocol ? A : AAAA);
+            record.setFlushCache(true);
+            record.setAddress(entry.ip());
+            records.append(record);
+        }
+    }
+    return records;
+}
+
 void HostnamePrivate::onMessageReceived(const Message &message)
 {
     if (message.isResponse()) {
@@ -123,7 +182,7 @@ void HostnamePrivate::onMessageReceived(const Message &message)
         }
         const auto records = message.records();
         for (const Record &record : records) {
-            if ((record.type() == A || record.type() == AAAA) && record.name() == hostname) {
+            if ((record.type() == A || record.type() == AAAA) && record.nameAtom() == hostnameAtom) {
                 ++hostnameSuffix;
                 assertHostname();
             }
@@ -132,17 +191,32 @@ void HostnamePrivate::onMessageReceived(const Message &message)
         if (!hostnameRegistered) {
             return;
         }
+        QMDNSENGINE_TRACE(TraceRespond);
         Message reply;
         reply.reply(message);
+        bool sendNsec = false;
         const auto queries = message.queries();
         for (const Query &query : queries) {
-            if ((query.type() == A || query.type() == AAAA) && query.name() == hostname) {
+            if (query.nameAtom() != hostnameAtom) {
+                continue;
+            }
+            if (query.type() == A || query.type() == AAAA) {
                 Record record;
                 if (generateRecord(message.address(), query.type(), record)) {
                     reply.addRecord(record);
+                } else {
+                    sendNsec = true;
                 }
+            } else if (query.type() != ANY) {
+                sendNsec = true;
             }
         }
+
+        // Assert which types exist so that the querier can stop asking for
+        // the ones that do not (for example, AAAA on an IPv4-only host)
+        if (sendNsec) {
+            reply.addRecord(generateNsecRecord(message.address()));
+        }
         if (reply.records().size()) {
             server->sendMessage(reply);
         }
@@ -156,6 +230,14 @@ void HostnamePrivate::onRegistrationTimeout()
         emit q->hostnameChanged(hostname);
     }
 
+    // Announce the addresses for the hostname, saying goodbye to the old
+    // ones if the name changed
+    if (hostname != hostnamePrev && !announcedRecords.isEmpty()) {
+        announcer->goodbye(announcedRecords);
+    }
+    announcedRecords = generateRecords();
+    announcer->announce(announcedRecords);
+
     // Re-assert the hostname in half an hour
     rebroadcastTimer.start();
 }
@@ -25,18 +25,22 @@
 #ifndef QMDNSENGINE_HOSTNAME_P_H
 #define QMDNSENGINE_HOSTNAME_P_H
 
+#include <QList>
 #include <QObject>
 #include <QTimer>
 
+#include <qmdnsengine/nameatom.h>
+#include <qmdnsengine/record.h>
+
 class QHostAddress;
 
 namespace QMdnsEngine
 {
 
 class AbstractServer;
+class Announcer;
 class Hostname;
 class Message;
-class Record;
 
 class HostnamePrivate : public QObject
 {
@@ -45,14 +49,21 @@ class HostnamePrivate : public QObject
 public:
 
     HostnamePrivate(Hostname *hostname, AbstractServer *server);
+    virtual ~HostnamePrivate();
 
     void assertHostname();
     bool generateRecord(const QHostAddress &srcAddress, quint16 type, Record &record);
+    Record generateNsecRecord(const QHostAddress &srcAddress);
+    QList<Record> generateRecords() const;
 
     AbstractServer *server;
+    int listenerId;
+    Announcer *announcer;
+    QList<Record> announcedRecords;
 
     QByteArray hostnamePrev;
     QByteArray hostname;
+    NameAtom hostnameAtom;
     bool hostnameRegistered;
     int hostnameSuffix;
 
@@ -131,6 +131,16 @@ void Message::addRecord(const Record &record)
     d->records.push_back(record);
 }
 
+std::list<Record> Message::authorityRecords() const
+{
+    return d->authorityRecords;
+}
+
+void Message::addAuthorityRecord(const Record &record)
+{
+    d->authorityRecords.push_back(record);
+}
+
 void Message::reply(const Message &other)
 {
     if (other.port() == MdnsPort) {
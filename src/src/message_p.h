@@ -48,6 +48,7 @@ public:
     bool isTruncated;
     std::list<Query> queries;
     std::list<Record> records;
+    std::list<Record> authorityRecords;
 };
 
 }
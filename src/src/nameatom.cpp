@@ -0,0 +1,220 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHash>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QWriteLocker>
+
+#include <qmdnsengine/nameatom.h>
+
+using namespace QMdnsEngine;
+
+namespace
+{
+
+// Entries are only added and removed while the write lock is held; an entry
+// is never visible in the table with a reference count of zero. Names are
+// looked up with the read lock only, so that threads looking up names that
+// are already interned do not block each other
+struct NameTable
+{
+    QReadWriteLock lock;
+    QHash<QByteArray, NameAtomData*> entries;
+};
+
+// Take a reference to the entry for a spelling or, failing that, the one
+// for the lowercase spelling; this only needs the read lock since the
+// references of entries in the table never drop to zero without the write
+// lock held
+NameAtomData *findLocked(const NameTable &table, const QByteArray &name, bool canonical)
+{
+    NameAtomData *data = table.entries.value(name);
+    if (!data && canonical) {
+        data = table.entries.value(NameAtom::canonicalize(name));
+    }
+    if (data) {
+        data->ref.ref();
+    }
+    return data;
+}
+
+NameTable &nameTable()
+{
+    // Never destroyed, since atoms held in static objects may outlive it
+    static NameTable *table = new NameTable;
+    return *table;
+}
+
+NameAtomData *internLocked(NameTable &table, const QByteArray &name)
+{
+    NameAtomData *data = table.entries.value(name);
+    if (data) {
+        data->ref.ref();
+        return data;
+    }
+
+    // A spelling with uppercase letters holds a reference to the entry for
+    // the lowercase spelling, which is created first if necessary
+    QByteArray canonicalName = NameAtom::canonicalize(name);
+    data = new NameAtomData(name);
+    if (canonicalName == name) {
+        data->canonical = data;
+        data->hash = qHash(name);
+    } else {
+        data->canonical = internLocked(table, canonicalName);
+    }
+    table.entries.insert(name, data);
+    return data;
+}
+
+NameAtomData *intern(const QByteArray &name)
+{
+    // Most names are already interned, which only needs the read lock
+    NameTable &table = nameTable();
+    {
+        QReadLocker locker(&table.lock);
+        NameAtomData *data = findLocked(table, name, false);
+        if (data) {
+            return data;
+        }
+    }
+    QWriteLocker locker(&table.lock);
+    return internLocked(table, name);
+}
+
+void releaseLocked(NameTable &table, NameAtomData *data)
+{
+    if (!data->ref.deref()) {
+        NameAtomData *canonical = data->canonical;
+        table.entries.remove(data->name);
+        delete data;
+        if (canonical != data) {
+            releaseLocked(table, canonical);
+        }
+    }
+}
+
+void release(NameAtomData *data)
+{
+    // Dropping a reference that is not the last one needs no lock since
+    // only holders can create new references (other than interning)
+    int value = data->ref.loadAcquire();
+    while (value > 1) {
+        if (data->ref.testAndSetOrdered(value, value - 1, value)) {
+            return;
+        }
+    }
+
+    // The last reference is dropped with the lock held so that the entry
+    // cannot be found by intern() in the meantime
+    NameTable &table = nameTable();
+    QWriteLocker locker(&table.lock);
+    releaseLocked(table, data);
+}
+
+}
+
+NameAtom::NameAtom()
+    : d(0)
+{
+}
+
+NameAtom::NameAtom(const QByteArray &name)
+    : d(name.isNull() ? 0 : intern(name))
+{
+}
+
+NameAtom::NameAtom(const NameAtom &other)
+    : d(other.d)
+{
+    if (d) {
+        d->ref.ref();
+    }
+}
+
+NameAtom &NameAtom::operator=(const NameAtom &other)
+{
+    if (other.d) {
+        other.d->ref.ref();
+    }
+    if (d) {
+        release(d);
+    }
+    d = other.d;
+    return *this;
+}
+
+NameAtom::~NameAtom()
+{
+    if (d) {
+        release(d);
+    }
+}
+
+QByteArray NameAtom::name() const
+{
+    return d ? d->name : QByteArray();
+}
+
+QByteArray NameAtom::canonicalName() const
+{
+    return d ? d->canonical->name : QByteArray();
+}
+
+NameAtom NameAtom::find(const QByteArray &name)
+{
+    NameAtom atom;
+    if (!name.isNull()) {
+        NameTable &table = nameTable();
+        QReadLocker locker(&table.lock);
+        atom.d = findLocked(table, name, true);
+    }
+    return atom;
+}
+
+int NameAtom::tableSize()
+{
+    NameTable &table = nameTable();
+    QReadLocker locker(&table.lock);
+    return table.entries.size();
+}
+
+QByteArray NameAtom::canonicalize(const QByteArray &name)
+{
+    // Only copy the name if it contains uppercase letters
+    for (int i = 0; i < name.length(); ++i) {
+        if (name.at(i) >= 'A' && name.at(i) <= 'Z') {
+            QByteArray canonicalName = name;
+            for (int j = i; j < canonicalName.length(); ++j) {
+                char c = canonicalName.at(j);
+                if (c >= 'A' && c <= 'Z') {
+                    canonicalName[j] = c - 'A' + 'a';
+                }
+            }
+            return canonicalName;
+        }
+    }
+    return name;
+}
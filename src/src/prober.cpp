@@ -22,8 +22,18 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
+#include <QHash>
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/prober.h>
 #include <qmdnsengine/query.h>
@@ -32,12 +42,236 @@
 
 using namespace QMdnsEngine;
 
+// Timing as described in RFC 6762, section 8.1: three probes sent 250 ms
+// apart, with the name considered unique 250 ms after the last one
+const int ProbeInterval = 250;
+const int ProbeCount = 3;
+
+// A host losing a simultaneous probe tiebreak waits one second before
+// probing again (RFC 6762, section 8.2)
+const int TiebreakDeferTicks = 4;
+
+static QHash<AbstractServer*, ProberEngine*> engines;
+
+// Build the bytes used to lexicographically compare records: the class
+// (without the cache-flush bit), followed by the type and the raw rdata
+static QByteArray tiebreakKey(const Record &record)
+{
+    Record copy = record;
+    copy.setName(QByteArray());
+    copy.setFlushCache(false);
+
+    QByteArray packet;
+    quint16 offset = 0;
+    QMap<QByteArray, quint16> nameMap;
+    writeRecord(packet, offset, copy, nameMap);
+
+    // The empty name occupies a single byte, followed by the type (2), the
+    // class (2), the TTL (4) and the rdata length (2)
+    return packet.mid(3, 2) + packet.mid(1, 2) + packet.mid(11);
+}
+
+// Compare our records against those from a simultaneous probe; a negative
+// value indicates that the other host wins
+static int compareProbes(QList<QByteArray> ours, QList<QByteArray> theirs)
+{
+    std::sort(ours.begin(), ours.end());
+    std::sort(theirs.begin(), theirs.end());
+    for (int i = 0; i < ours.size() && i < theirs.size(); ++i) {
+        if (ours.at(i) < theirs.at(i)) {
+            return -1;
+        }
+        if (theirs.at(i) < ours.at(i)) {
+            return 1;
+        }
+    }
+    return ours.size() - theirs.size();
+}
+
+ProberEngine *ProberEngine::acquire(AbstractServer *server)
+{
+    ProberEngine *engine = engines.value(server);
+    if (!engine) {
+        engine = new ProberEngine(server);
+        engines.insert(server, engine);
+    }
+    ++engine->refCount;
+    return engine;
+}
+
+void ProberEngine::release(ProberEngine *engine)
+{
+    if (!--engine->refCount) {
+        engines.remove(engine->server);
+        delete engine;
+    }
+}
+
+ProberEngine::ProberEngine(AbstractServer *server)
+    : server(server),
+      refCount(0)
+{
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
+    });
+
+    timer.callOnTimeout([this] {
+        onTimeout();
+    });
+    timer.setSingleShot(true);
+}
+
+ProberEngine::~ProberEngine()
+{
+    server->removeMessageListener(listenerId);
+}
+
+void ProberEngine::add(ProberPrivate *prober)
+{
+    if (!probers.contains(prober)) {
+        probers.append(prober);
+    }
+
+    // The first probe is delayed by a random amount between 0 and 250 ms to
+    // avoid colliding with other hosts that started at the same time; names
+    // added while probing is underway simply join the next round
+    if (!timer.isActive()) {
+#ifdef USE_QRANDOMGENERATOR
+        timer.start(QRandomGenerator::global()->bounded(ProbeInterval));
+#else
+        timer.start(qrand() % ProbeInterval);
+#endif
+    }
+}
+
+void ProberEngine::remove(ProberPrivate *prober)
+{
+    probers.removeOne(prober);
+    if (probers.isEmpty()) {
+        timer.stop();
+    }
+}
+
+void ProberEngine::onMessageReceived(const Message &message)
+{
+    const auto current = probers;
+
+    if (message.isResponse()) {
+
+        // Any response containing a record with a name that is being probed
+        // indicates that the name is already in use - pick a new one
+        const auto records = message.records();
+        for (ProberPrivate *prober : current) {
+            for (const Record &record : records) {
+                if (record.nameAtom() == prober->proposedRecord.nameAtom()) {
+                    ++prober->suffix;
+                    prober->assertRecord();
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    // A query with records in the authority section is a probe from another
+    // host; if it claims a name we are probing, the lexicographically later
+    // set of records wins
+    const auto authorityRecords = message.authorityRecords();
+    if (authorityRecords.empty()) {
+        return;
+    }
+    for (ProberPrivate *prober : current) {
+        QList<QByteArray> theirs;
+        for (const Record &record : authorityRecords) {
+            if (record.nameAtom() == prober->proposedRecord.nameAtom()) {
+                theirs.append(tiebreakKey(record));
+            }
+        }
+        if (theirs.isEmpty()) {
+            continue;
+        }
+        if (compareProbes({tiebreakKey(prober->proposedRecord)}, theirs) < 0) {
+            prober->probesSent = 0;
+            prober->deferTicks = TiebreakDeferTicks;
+        }
+    }
+}
+
+void ProberEngine::onTimeout()
+{
+    // Sort the probers into those due to send another probe and those that
+    // have completed all of their probes without a conflict
+    QList<ProberPrivate*> due;
+    QList<ProberPrivate*> done;
+    const auto current = probers;
+    for (ProberPrivate *prober : current) {
+        if (prober->deferTicks > 0) {
+            --prober->deferTicks;
+        } else if (prober->probesSent < ProbeCount) {
+            due.append(prober);
+        } else {
+            done.append(prober);
+        }
+    }
+
+    sendProbes(due);
+    for (ProberPrivate *prober : due) {
+        ++prober->probesSent;
+    }
+
+    // Confirming a name may destroy the prober and, if it was the last one,
+    // the engine itself - hold a reference until finished
+    ++refCount;
+    for (ProberPrivate *prober : done) {
+        if (probers.removeOne(prober)) {
+            prober->confirm();
+        }
+    }
+    if (!probers.isEmpty()) {
+        timer.start(ProbeInterval);
+    }
+    release(this);
+}
+
+void ProberEngine::sendProbes(const QList<ProberPrivate*> &probers)
+{
+    // Each probe consists of an ANY query for the proposed name along with
+    // the proposed record in the authority section; probes for as many names
+    // as will fit are combined into a single packet
+
+    Message message;
+    int size = 12;
+    bool empty = true;
+    for (ProberPrivate *prober : probers) {
+        Query query;
+        query.setName(prober->proposedRecord.name());
+        query.setType(ANY);
+        query.setUnicastResponse(prober->probesSent == 0);
+
+        int probeSize = querySize(query) + recordSize(prober->proposedRecord);
+        if (!empty && size + probeSize > MdnsMaxPacketSize) {
+            server->sendMessageToAll(message);
+            message = Message();
+            size = 12;
+        }
+        message.addQuery(query);
+        message.addAuthorityRecord(prober->proposedRecord);
+        size += probeSize;
+        empty = false;
+    }
+    if (!empty) {
+        server->sendMessageToAll(message);
+    }
+}
+
 ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Record &record)
     : QObject(prober),
-      server(server),
+      engine(ProberEngine::acquire(server)),
       confirmed(false),
       proposedRecord(record),
       suffix(1),
+      probesSent(0),
+      deferTicks(0),
       q(prober)
 {
     // All records should contain at least one "."
@@ -45,16 +279,15 @@ ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Recor
     name = record.name().left(index);
     type = record.name().mid(index);
 
-    server->on<MessageReceived>([this](const MessageReceived& event, const AbstractServer&) {
-        onMessageReceived(event.message);
-    });
-    connect(&timer, &QTimer::timeout, this, &ProberPrivate::onTimeout);
-
-    timer.setSingleShot(true);
-
     assertRecord();
 }
 
+ProberPrivate::~ProberPrivate()
+{
+    engine->remove(this);
+    ProberEngine::release(engine);
+}
+
 void ProberPrivate::assertRecord()
 {
 	// Use the current suffix to set the name of the proposed record
@@ -64,39 +297,13 @@ void ProberPrivate::assertRecord()
 
 	proposedRecord.setName(tmpName.toUtf8());
 
-    // Broadcast a query for the proposed name (using an ANY query) and
-    // include the proposed record in the query
-    Query query;
-    query.setName(proposedRecord.name());
-    query.setType(ANY);
-    Message message;
-    message.addQuery(query);
-    message.addRecord(proposedRecord);
-    server->sendMessageToAll(message);
-
-    // Wait two seconds to confirm it is unique
-    timer.stop();
-    timer.start(2 * 1000);
-}
-
-void ProberPrivate::onMessageReceived(const Message &message)
-{
-    // If the response matches the proposed record, increment the suffix and
-    // try with the new name
-
-    if (confirmed || !message.isResponse()) {
-        return;
-    }
-    const auto records = message.records();
-    for (const Record &record : records) {
-        if (record.name() == proposedRecord.name() && record.type() == proposedRecord.type()) {
-            ++suffix;
-            assertRecord();
-        }
-    }
+    // Start probing for the new name from the beginning
+    probesSent = 0;
+    deferTicks = 0;
+    engine->add(this);
 }
 
-void ProberPrivate::onTimeout()
+void ProberPrivate::confirm()
 {
     confirmed = true;
     emit q->nameConfirmed(proposedRecord.name());
@@ -25,6 +25,8 @@
 #ifndef QMDNSENGINE_PROBER_P_H
 #define QMDNSENGINE_PROBER_P_H
 
+#include <QByteArray>
+#include <QList>
 #include <QObject>
 #include <QTimer>
 
@@ -36,6 +38,7 @@ namespace QMdnsEngine
 class AbstractServer;
 class Message;
 class Prober;
+class ProberEngine;
 
 class ProberPrivate : public QObject
 {
@@ -44,29 +47,56 @@ class ProberPrivate : public QObject
 public:
 
     ProberPrivate(Prober *prober, AbstractServer *server, const Record &record);
+    virtual ~ProberPrivate();
 
     void assertRecord();
+    void confirm();
 
-    AbstractServer *server;
-    QTimer timer;
-
+    ProberEngine *engine;
     bool confirmed;
-
     Record proposedRecord;
     QByteArray name;
     QByteArray type;
     int suffix;
 
-private Q_SLOTS:
-
-    void onMessageReceived(const Message &message);
-    void onTimeout();
+    int probesSent;
+    int deferTicks;
 
 private:
 
     Prober *const q;
 };
 
+/*
+ * All probers using the same server share a single engine, which sends the
+ * probes for every pending name together on a common 250 ms schedule
+ */
+class ProberEngine
+{
+public:
+
+    static ProberEngine *acquire(AbstractServer *server);
+    static void release(ProberEngine *engine);
+
+    void add(ProberPrivate *prober);
+    void remove(ProberPrivate *prober);
+
+private:
+
+    explicit ProberEngine(AbstractServer *server);
+    ~ProberEngine();
+
+    void onMessageReceived(const Message &message);
+    void onTimeout();
+    void sendProbes(const QList<ProberPrivate*> &probers);
+
+    AbstractServer *server;
+    int listenerId;
+    int refCount;
+    QTimer timer;
+    QList<ProberPrivate*> probers;
+};
+
 }
 
 #endif // QMDNSENGINE_PROBER_P_H
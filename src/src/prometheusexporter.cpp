@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QTcpSocket>
+
+#include <qmdnsengine/prometheusexporter.h>
+#include <qmdnsengine/statistics.h>
+
+#include "prometheusexporter_p.h"
+
+using namespace QMdnsEngine;
+
+// Requests with larger headers are not from a metrics scraper
+static const int MaxRequestSize = 8192;
+
+PrometheusExporterPrivate::PrometheusExporterPrivate(AbstractServer *server, Cache *cache)
+    : server(server),
+      cache(cache)
+{
+    QObject::connect(&tcpServer, &QTcpServer::newConnection, [this]() {
+        onNewConnection();
+    });
+}
+
+void PrometheusExporterPrivate::onNewConnection()
+{
+    while (QTcpSocket *socket = tcpServer.nextPendingConnection()) {
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+
+        // Respond once the request headers have been received - the request
+        // itself is not inspected since there is only one thing to serve
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+            QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+            if (!request.contains("\r\n\r\n")) {
+                if (request.length() > MaxRequestSize) {
+                    socket->abort();
+                    return;
+                }
+                socket->setProperty("request", request);
+                return;
+            }
+            QByteArray body = StatisticsSnapshot::take(server, cache).toPrometheus();
+            socket->write("HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: " + QByteArray::number(body.length()) + "\r\n"
+                          "Connection: close\r\n"
+                          "\r\n");
+            socket->write(body);
+            socket->disconnectFromHost();
+        });
+    }
+}
+
+PrometheusExporter::PrometheusExporter(AbstractServer *server, Cache *cache)
+    : d(new PrometheusExporterPrivate(server, cache))
+{
+}
+
+PrometheusExporter::~PrometheusExporter()
+{
+    delete d;
+}
+
+bool PrometheusExporter::listen(const QHostAddress &address, quint16 port)
+{
+    return d->tcpServer.listen(address, port);
+}
+
+quint16 PrometheusExporter::port() const
+{
+    return d->tcpServer.serverPort();
+}
+
+void PrometheusExporter::close()
+{
+    d->tcpServer.close();
+}
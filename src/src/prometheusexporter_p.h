@@ -22,28 +22,30 @@
  * IN THE SOFTWARE.
  */
 
-#ifndef QMDNSENGINE_BITMAP_P_H
-#define QMDNSENGINE_BITMAP_P_H
+#ifndef QMDNSENGINE_PROMETHEUSEXPORTER_P_H
+#define QMDNSENGINE_PROMETHEUSEXPORTER_P_H
 
-#include <QtGlobal>
+#include <QTcpServer>
 
 namespace QMdnsEngine
 {
 
-class BitmapPrivate
+class AbstractServer;
+class Cache;
+
+class PrometheusExporterPrivate
 {
 public:
 
-    BitmapPrivate();
-    virtual ~BitmapPrivate();
+    PrometheusExporterPrivate(AbstractServer *server, Cache *cache);
 
-    void free();
-    void fromData(quint8 newLength, const quint8 *newData);
+    void onNewConnection();
 
-    quint8 length;
-    quint8 *data;
+    AbstractServer *server;
+    Cache *cache;
+    QTcpServer tcpServer;
 };
 
 }
 
-#endif // QMDNSENGINE_BITMAP_P_H
+#endif // QMDNSENGINE_PROMETHEUSEXPORTER_P_H
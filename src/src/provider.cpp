@@ -23,6 +23,7 @@
  */
 
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/bitmap.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
 #include <qmdnsengine/mdns.h>
@@ -31,20 +32,23 @@
 #include <qmdnsengine/provider.h>
 #include <qmdnsengine/query.h>
 
+#include "announcer_p.h"
 #include "provider_p.h"
+#include "tracing_p.h"
 
 using namespace QMdnsEngine;
 
 ProviderPrivate::ProviderPrivate(QObject *parent, AbstractServer *server, Hostname *hostname)
     : QObject(parent),
       server(server),
+      announcer(Announcer::acquire(server)),
       hostname(hostname),
       prober(nullptr),
       initialized(false),
       confirmed(false)
 {
-    server->on<MessageReceived>([this](const MessageReceived& event, const AbstractServer&) {
-        onMessageReceived(event.message);
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
     });
     connect(hostname, &Hostname::hostnameChanged, this, &ProviderPrivate::onHostnameChanged);
 
@@ -57,21 +61,19 @@ ProviderPrivate::ProviderPrivate(QObject *parent, AbstractServer *server, Hostna
 
 ProviderPrivate::~ProviderPrivate()
 {
+    server->removeMessageListener(listenerId);
     if (confirmed) {
         farewell();
     }
+    Announcer::release(announcer);
 }
 
 void ProviderPrivate::announce()
 {
-    // Broadcast a message with each of the records
-
-    Message message;
-    message.setResponse(true);
-    message.addRecord(ptrRecord);
-    message.addRecord(srvRecord);
-    message.addRecord(txtRecord);
-    server->sendMessageToAll(message);
+    // Have the announcer broadcast each of the records (it takes care of
+    // repeating them and combining them with other announcements)
+
+    announcer->announce({browsePtrRecord, ptrRecord, srvRecord, txtRecord});
 }
 
 void ProviderPrivate::confirm()
@@ -107,13 +109,13 @@ void ProviderPrivate::confirm()
 
 void ProviderPrivate::farewell()
 {
-    // Send a message indicating that the existing records are no longer valid
-    // by setting their TTL to 0
+    // Indicate that the existing records are no longer valid - the announcer
+    // sends them with a TTL of 0 along with any other pending goodbyes (the
+    // browse PTR record is shared with other providers of the same type and
+    // is left alone)
 
-    ptrRecord.setTtl(0);
-    srvRecord.setTtl(0);
-    txtRecord.setTtl(0);
-    announce();
+    announcer->cancel({browsePtrRecord});
+    announcer->goodbye({ptrRecord, srvRecord, txtRecord});
 }
 
 void ProviderPrivate::publish()
@@ -124,6 +126,18 @@ void ProviderPrivate::publish()
     ptrRecord = ptrProposed;
     srvRecord = srvProposed;
     txtRecord = txtProposed;
+
+    // The NSEC record asserts that the service instance has no records
+    // other than the SRV and TXT records
+    Bitmap bitmap;
+    bitmap.setBit(SRV);
+    bitmap.setBit(TXT);
+    nsecRecord.setName(srvRecord.name());
+    nsecRecord.setType(NSEC);
+    nsecRecord.setFlushCache(true);
+    nsecRecord.setNextDomainName(srvRecord.name());
+    nsecRecord.setBitmap(bitmap);
+
     announce();
 }
 
@@ -132,23 +146,27 @@ void ProviderPrivate::onMessageReceived(const Message &message)
     if (!confirmed || message.isResponse()) {
         return;
     }
+    QMDNSENGINE_TRACE(TraceRespond);
 
     bool sendBrowsePtr = false;
     bool sendPtr = false;
     bool sendSrv = false;
     bool sendTxt = false;
+    bool sendNsec = false;
 
     // Determine which records to send based on the queries
     const auto queries = message.queries();
     for (const Query &query : queries) {
         if (query.type() == PTR && query.name() == MdnsBrowseType) {
             sendBrowsePtr = true;
-        } else if (query.type() == PTR && query.name() == ptrRecord.name()) {
+        } else if (query.type() == PTR && query.nameAtom() == ptrRecord.nameAtom()) {
             sendPtr = true;
-        } else if (query.type() == SRV && query.name() == srvRecord.name()) {
+        } else if (query.type() == SRV && query.nameAtom() == srvRecord.nameAtom()) {
             sendSrv = true;
-        } else if (query.type() == TXT && query.name() == txtRecord.name()) {
+        } else if (query.type() == TXT && query.nameAtom() == txtRecord.nameAtom()) {
             sendTxt = true;
+        } else if (query.type() != ANY && query.nameAtom() == srvRecord.nameAtom()) {
+            sendNsec = true;
         }
     }
 
@@ -170,7 +188,7 @@ void ProviderPrivate::onMessageReceived(const Message &message)
     }
 
     // If any records should be sent, compose a message reply
-    if (sendBrowsePtr || sendPtr || sendSrv || sendTxt) {
+    if (sendBrowsePtr || sendPtr || sendSrv || sendTxt || sendNsec) {
         Message reply;
         reply.reply(message);
         if (sendBrowsePtr) {
@@ -185,6 +203,9 @@ void ProviderPrivate::onMessageReceived(const Message &message)
         if (sendTxt) {
             reply.addRecord(txtRecord);
         }
+        if (sendNsec) {
+            reply.addRecord(nsecRecord);
+        }
         server->sendMessage(reply);
     }
 }
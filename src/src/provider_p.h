@@ -34,6 +34,7 @@ namespace QMdnsEngine
 {
 
 class AbstractServer;
+class Announcer;
 class Hostname;
 class Message;
 class Prober;
@@ -53,6 +54,8 @@ public:
     void publish();
 
     AbstractServer *server;
+    int listenerId;
+    Announcer *announcer;
     Hostname *hostname;
     Prober *prober;
 
@@ -64,6 +67,7 @@ public:
     Record ptrRecord;
     Record srvRecord;
     Record txtRecord;
+    Record nsecRecord;
 
     Record browsePtrProposed;
     Record ptrProposed;
@@ -61,12 +61,17 @@ Query::~Query()
 
 QByteArray Query::name() const
 {
-    return d->name;
+    return d->name.name();
 }
 
 void Query::setName(const QByteArray &name)
 {
-    d->name = name;
+    d->name = NameAtom(name);
+}
+
+const NameAtom &Query::nameAtom() const
+{
+    return d->name;
 }
 
 quint16 Query::type() const
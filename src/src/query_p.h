@@ -27,6 +27,8 @@
 
 #include <QByteArray>
 
+#include <qmdnsengine/nameatom.h>
+
 namespace QMdnsEngine
 {
 
@@ -36,7 +38,7 @@ public:
 
     QueryPrivate();
 
-    QByteArray name;
+    NameAtom name;
     quint16 type;
     bool unicastResponse;
 };
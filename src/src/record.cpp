@@ -22,6 +22,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <cstring>
+#include <type_traits>
+
 #include <QDebug>
 
 #include <qmdnsengine/dns.h>
@@ -31,14 +34,147 @@
 
 using namespace QMdnsEngine;
 
+// Address and PTR records (by far the most common) fit in 40 bytes on 64-bit
+// platforms, down from about 200 when every field was stored; alternatives
+// that do not fit inline belong behind a pointer like NSEC and TXT data
+static_assert(sizeof(RecordPrivate) <= 40, "RecordPrivate must not grow beyond 40 bytes");
+
+namespace
+{
+
+bool dataEquals(std::monostate, std::monostate)
+{
+    return true;
+}
+
+bool dataEquals(const Ipv4Data &a, const Ipv4Data &b)
+{
+    return a.address == b.address;
+}
+
+bool dataEquals(const Ipv6Data &a, const Ipv6Data &b)
+{
+    return memcmp(&a.address, &b.address, sizeof(Q_IPV6ADDR)) == 0;
+}
+
+bool dataEquals(const QHostAddress &a, const QHostAddress &b)
+{
+    return a == b;
+}
+
+bool dataEquals(const NameAtom &a, const NameAtom &b)
+{
+    return a == b;
+}
+
+bool dataEquals(const ServiceData &a, const ServiceData &b)
+{
+    return a.target == b.target &&
+        a.priority == b.priority &&
+        a.weight == b.weight &&
+        a.port == b.port;
+}
+
+bool dataEquals(const std::shared_ptr<const TxtData> &a, const std::shared_ptr<const TxtData> &b)
+{
+    return a == b || a->data == b->data;
+}
+
+bool dataEquals(const std::shared_ptr<NsecData> &a, const std::shared_ptr<NsecData> &b)
+{
+    return a == b || (a->nextDomainName == b->nextDomainName && a->bitmap == b->bitmap);
+}
+
+void appendAttribute(QByteArray &data, const QByteArray &key, const QByteArray &value)
+{
+    QByteArray entry = value.isNull() ? key : key + "=" + value;
+    entry.truncate(255);
+    data.append(static_cast<char>(entry.length()));
+    data.append(entry);
+}
+
+QByteArray encodeAttributes(const QMap<QByteArray, QByteArray> &attributes)
+{
+    QByteArray data;
+    for (auto i = attributes.constBegin(); i != attributes.constEnd(); ++i) {
+        appendAttribute(data, i.key(), i.value());
+    }
+    return data;
+}
+
+// Determine if the TXT data has a string for the key without splitting it
+// into attributes
+bool containsKey(const QByteArray &data, const QByteArray &key)
+{
+    for (int offset = 0; offset < data.length();) {
+        int length = static_cast<quint8>(data.at(offset++));
+        length = qMin(length, data.length() - offset);
+        if (length >= key.length() &&
+                memcmp(data.constData() + offset, key.constData(), key.length()) == 0 &&
+                (length == key.length() || data.at(offset + key.length()) == '=')) {
+            return true;
+        }
+        offset += length;
+    }
+    return false;
+}
+
+}
+
+const QMap<QByteArray, QByteArray> &TxtData::attributes() const
+{
+    std::call_once(parsed, [this] {
+        for (int offset = 0; offset < data.length();) {
+            int length = static_cast<quint8>(data.at(offset++));
+            length = qMin(length, data.length() - offset);
+            QByteArray entry = data.mid(offset, length);
+            offset += length;
+
+            // Empty strings and strings without a key are ignored and only
+            // the first occurrence of each key is used
+            int splitIndex = entry.indexOf('=');
+            if (entry.isEmpty() || splitIndex == 0) {
+                continue;
+            }
+            QByteArray key = splitIndex == -1 ? entry : entry.left(splitIndex);
+            if (!parsedAttributes.contains(key)) {
+                parsedAttributes.insert(key, splitIndex == -1 ? QByteArray() : entry.mid(splitIndex + 1));
+            }
+        }
+    });
+    return parsedAttributes;
+}
+
 RecordPrivate::RecordPrivate()
-    : type(0),
-      flushCache(false),
-      ttl(3600),
-      priority(0),
-      weight(0),
-      port(0)
+    : ttl(3600),
+      type(0),
+      flushCache(false)
+{
+}
+
+ServiceData &RecordPrivate::service()
 {
+    ServiceData *service = std::get_if<ServiceData>(&data);
+    if (!service) {
+
+        // Keep a target that was set before the other SRV fields
+        const NameAtom *target = std::get_if<NameAtom>(&data);
+        data = ServiceData{target ? *target : NameAtom(), 0, 0, 0};
+        service = std::get_if<ServiceData>(&data);
+    }
+    return *service;
+}
+
+NsecData &RecordPrivate::nsec()
+{
+    std::shared_ptr<NsecData> *nsec = std::get_if<std::shared_ptr<NsecData>>(&data);
+    if (!nsec) {
+        data = std::make_shared<NsecData>();
+        nsec = std::get_if<std::shared_ptr<NsecData>>(&data);
+    } else if (nsec->use_count() > 1) {
+        *nsec = std::make_shared<NsecData>(**nsec);
+    }
+    return **nsec;
 }
 
 Record::Record()
@@ -62,14 +198,11 @@ bool Record::operator==(const Record &other) const
 {
     return d->name == other.d->name &&
         d->type == other.d->type &&
-        d->address == other.d->address &&
-        d->target == other.d->target &&
-        d->nextDomainName == other.d->nextDomainName &&
-        d->priority == other.d->priority &&
-        d->weight == other.d->weight &&
-        d->port == other.d->port &&
-        d->attributes == other.d->attributes &&
-        d->bitmap == other.d->bitmap;
+        d->data.index() == other.d->data.index() &&
+        std::visit([&other](const auto &value) {
+            typedef std::decay_t<decltype(value)> T;
+            return dataEquals(value, std::get<T>(other.d->data));
+        }, d->data);
 }
 
 bool Record::operator!=(const Record &other) const
@@ -84,12 +217,17 @@ Record::~Record()
 
 QByteArray Record::name() const
 {
-    return d->name;
+    return d->name.name();
 }
 
 void Record::setName(const QByteArray &name)
 {
-    d->name = name;
+    d->name = NameAtom(name);
+}
+
+const NameAtom &Record::nameAtom() const
+{
+    return d->name;
 }
 
 quint16 Record::type() const
@@ -124,87 +262,151 @@ void Record::setTtl(quint32 ttl)
 
 QHostAddress Record::address() const
 {
-    return d->address;
+    if (const Ipv4Data *ipv4 = std::get_if<Ipv4Data>(&d->data)) {
+        return QHostAddress(ipv4->address);
+    }
+    if (const Ipv6Data *ipv6 = std::get_if<Ipv6Data>(&d->data)) {
+        return QHostAddress(ipv6->address);
+    }
+    if (const QHostAddress *address = std::get_if<QHostAddress>(&d->data)) {
+        return *address;
+    }
+    return QHostAddress();
 }
 
 void Record::setAddress(const QHostAddress &address)
 {
-    d->address = address;
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        d->data = Ipv4Data{address.toIPv4Address()};
+    } else if (address.protocol() == QAbstractSocket::IPv6Protocol && address.scopeId().isEmpty()) {
+        d->data = Ipv6Data{address.toIPv6Address()};
+    } else if (!address.isNull()) {
+        d->data = address;
+    } else if (std::holds_alternative<Ipv4Data>(d->data) ||
+            std::holds_alternative<Ipv6Data>(d->data) ||
+            std::holds_alternative<QHostAddress>(d->data)) {
+        d->data = std::monostate();
+    }
 }
 
 QByteArray Record::target() const
 {
-    return d->target;
+    if (const ServiceData *service = std::get_if<ServiceData>(&d->data)) {
+        return service->target.name();
+    }
+    if (const NameAtom *target = std::get_if<NameAtom>(&d->data)) {
+        return target->name();
+    }
+    return QByteArray();
 }
 
 void Record::setTarget(const QByteArray &target)
 {
-    d->target = target;
+    if (ServiceData *service = std::get_if<ServiceData>(&d->data)) {
+        service->target = NameAtom(target);
+    } else {
+        d->data = NameAtom(target);
+    }
 }
 
 QByteArray Record::nextDomainName() const
 {
-    return d->nextDomainName;
+    if (const std::shared_ptr<NsecData> *nsec = std::get_if<std::shared_ptr<NsecData>>(&d->data)) {
+        return (*nsec)->nextDomainName;
+    }
+    return QByteArray();
 }
 
 void Record::setNextDomainName(const QByteArray &nextDomainName)
 {
-    d->nextDomainName = nextDomainName;
+    d->nsec().nextDomainName = nextDomainName;
 }
 
 quint16 Record::priority() const
 {
-    return d->priority;
+    const ServiceData *service = std::get_if<ServiceData>(&d->data);
+    return service ? service->priority : 0;
 }
 
 void Record::setPriority(quint16 priority)
 {
-    d->priority = priority;
+    d->service().priority = priority;
 }
 
 quint16 Record::weight() const
 {
-    return d->weight;
+    const ServiceData *service = std::get_if<ServiceData>(&d->data);
+    return service ? service->weight : 0;
 }
 
 void Record::setWeight(quint16 weight)
 {
-    d->weight = weight;
+    d->service().weight = weight;
 }
 
 quint16 Record::port() const
 {
-    return d->port;
+    const ServiceData *service = std::get_if<ServiceData>(&d->data);
+    return service ? service->port : 0;
 }
 
 void Record::setPort(quint16 port)
 {
-    d->port = port;
+    d->service().port = port;
 }
 
 QMap<QByteArray, QByteArray> Record::attributes() const
 {
-    return d->attributes;
+    if (const std::shared_ptr<const TxtData> *txt = std::get_if<std::shared_ptr<const TxtData>>(&d->data)) {
+        return (*txt)->attributes();
+    }
+    return QMap<QByteArray, QByteArray>();
 }
 
 void Record::setAttributes(const QMap<QByteArray, QByteArray> &attributes)
 {
-    d->attributes = attributes;
+    setTxtData(encodeAttributes(attributes));
 }
 
 void Record::addAttribute(const QByteArray &key, const QByteArray &value)
 {
-    d->attributes.insert(key, value);
+    // Only an existing key requires the data to be rewritten; otherwise the
+    // new string is appended as-is
+    QByteArray data = txtData();
+    if (key.isEmpty() || containsKey(data, key)) {
+        QMap<QByteArray, QByteArray> newAttributes = attributes();
+        newAttributes.insert(key, value);
+        setAttributes(newAttributes);
+    } else {
+        appendAttribute(data, key, value);
+        setTxtData(data);
+    }
+}
+
+QByteArray Record::txtData() const
+{
+    if (const std::shared_ptr<const TxtData> *txt = std::get_if<std::shared_ptr<const TxtData>>(&d->data)) {
+        return (*txt)->data;
+    }
+    return QByteArray();
+}
+
+void Record::setTxtData(const QByteArray &txtData)
+{
+    d->data = std::shared_ptr<const TxtData>(std::make_shared<TxtData>(txtData));
 }
 
 Bitmap Record::bitmap() const
 {
-    return d->bitmap;
+    if (const std::shared_ptr<NsecData> *nsec = std::get_if<std::shared_ptr<NsecData>>(&d->data)) {
+        return (*nsec)->bitmap;
+    }
+    return Bitmap();
 }
 
 void Record::setBitmap(const Bitmap &bitmap)
 {
-    d->bitmap = bitmap;
+    d->nsec().bitmap = bitmap;
 }
 
 QDebug QMdnsEngine::operator<<(QDebug dbg, const Record &record)
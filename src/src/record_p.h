@@ -25,33 +25,92 @@
 #ifndef QMDNSENGINE_RECORD_P_H
 #define QMDNSENGINE_RECORD_P_H
 
+#include <memory>
+#include <mutex>
+#include <variant>
+
 #include <QByteArray>
 #include <QHostAddress>
 #include <QMap>
 
 #include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/nameatom.h>
 
 namespace QMdnsEngine {
 
+// Addresses without a scope ID are stored in their raw form to avoid the
+// allocation that every QHostAddress carries
+struct Ipv4Data
+{
+    quint32 address;
+};
+
+struct Ipv6Data
+{
+    Q_IPV6ADDR address;
+};
+
+struct ServiceData
+{
+    NameAtom target;
+    quint16 priority;
+    quint16 weight;
+    quint16 port;
+};
+
+// NSEC records are rare and their data is large, so it is kept out of line
+// and shared between copies until modified
+struct NsecData
+{
+    QByteArray nextDomainName;
+    Bitmap bitmap;
+};
+
+// TXT data is kept in wire format and only split into attributes when they
+// are requested
+struct TxtData
+{
+    explicit TxtData(const QByteArray &data) : data(data) {}
+
+    const QMap<QByteArray, QByteArray> &attributes() const;
+
+    QByteArray data;
+
+    // Parsed once so that Record::attributes() only copies a shared map
+    mutable std::once_flag parsed;
+    mutable QMap<QByteArray, QByteArray> parsedAttributes;
+};
+
+// A name on its own is the target of a PTR record
+typedef std::variant<
+    std::monostate,
+    Ipv4Data,
+    Ipv6Data,
+    QHostAddress,
+    NameAtom,
+    ServiceData,
+    std::shared_ptr<const TxtData>,
+    std::shared_ptr<NsecData>
+> RecordData;
+
 class RecordPrivate
 {
 public:
 
     RecordPrivate();
 
-    QByteArray name;
+    ServiceData &service();
+    NsecData &nsec();
+
+    // Names recur across many records and are therefore interned
+    NameAtom name;
+    quint32 ttl;
     quint16 type;
     bool flushCache;
-    quint32 ttl;
 
-    QHostAddress address;
-    QByteArray target;
-    QByteArray nextDomainName;
-    quint16 priority;
-    quint16 weight;
-    quint16 port;
-    QMap<QByteArray, QByteArray> attributes;
-    Bitmap bitmap;
+    // Only the fields used by the type of the record are stored; the
+    // alternative is selected by the setters that were called
+    RecordData data;
 };
 
 }
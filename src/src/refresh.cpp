@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QPair>
+#include <QSet>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "refresh_p.h"
+
+namespace QMdnsEngine
+{
+
+void sendQueries(AbstractServer *server, const Cache *cache, const QList<Query> &queries)
+{
+    Message message;
+    int size = 12;
+    bool empty = true;
+
+    for (const Query &query : queries) {
+        QList<Record> knownAnswers;
+        cache->lookupKnownAnswers(query.name(), query.type(), knownAnswers);
+
+        // Start a new packet if the question and its known answers do not
+        // fit in the current one
+        int nBytes = querySize(query);
+        for (const Record &knownAnswer : knownAnswers) {
+            nBytes += recordSize(knownAnswer);
+        }
+        if (!empty && size + nBytes > MdnsMaxPacketSize) {
+            server->sendMessageToAll(message);
+            message = Message();
+            size = 12;
+        }
+        message.addQuery(query);
+        size += querySize(query);
+        empty = false;
+
+        // If the known answers still do not fit, the packet is marked as
+        // truncated and the remaining answers follow in the next one (RFC
+        // 6762, section 7.2)
+        for (const Record &knownAnswer : knownAnswers) {
+            int answerBytes = recordSize(knownAnswer);
+            if (size + answerBytes > MdnsMaxPacketSize) {
+                message.setTruncated(true);
+                server->sendMessageToAll(message);
+                message = Message();
+                size = 12;
+            }
+            message.addRecord(knownAnswer);
+            size += answerBytes;
+        }
+    }
+    if (!empty) {
+        server->sendMessageToAll(message);
+    }
+}
+
+void sendRefreshQueries(AbstractServer *server, const Cache *cache, const QList<Record> &records)
+{
+    // Each name and type only needs to be asked for once, regardless of how
+    // many of its records are expiring
+
+    QSet<QPair<QByteArray, quint16>> asked;
+    QList<Query> queries;
+
+    for (const Record &record : records) {
+        QPair<QByteArray, quint16> key(record.name(), record.type());
+        if (asked.contains(key)) {
+            continue;
+        }
+        asked.insert(key);
+
+        Query query;
+        query.setName(record.name());
+        query.setType(record.type());
+        queries.append(query);
+    }
+    sendQueries(server, cache, queries);
+}
+
+}
@@ -0,0 +1,55 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_REFRESH_P_H
+#define QMDNSENGINE_REFRESH_P_H
+
+#include <QList>
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Cache;
+class Query;
+class Record;
+
+/*
+ * Send the queries, combining them into as few packets as possible; records
+ * in the cache with enough time remaining are listed as known answers
+ * (RFC 6762, section 7.1)
+ */
+void sendQueries(AbstractServer *server, const Cache *cache, const QList<Query> &queries);
+
+/*
+ * Send queries to refresh the provided records, combining them into as few
+ * packets as possible; records still in the cache with enough time
+ * remaining are listed as known answers so that responders only send the
+ * records that are about to expire
+ */
+void sendRefreshQueries(AbstractServer *server, const Cache *cache, const QList<Record> &records);
+
+}
+
+#endif // QMDNSENGINE_REFRESH_P_H
@@ -25,6 +25,7 @@
 #include <QTimer>
 
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/batchresolver.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/cache.h>
 #include <qmdnsengine/message.h>
@@ -33,6 +34,7 @@
 #include <qmdnsengine/resolver.h>
 
 #include "resolver_p.h"
+#include "sharedcache_p.h"
 
 using namespace QMdnsEngine;
 
@@ -40,11 +42,23 @@ ResolverPrivate::ResolverPrivate(Resolver *resolver, AbstractServer *server, con
     : QObject(resolver),
       server(server),
       name(name),
-      cache(cache ? cache : new Cache()),
+      nameAtom(name),
+      cache(cache),
+      sharedCache(nullptr),
+      failed(false),
       q(resolver)
 {
-    server->on<MessageReceived>([this](const MessageReceived& event, const AbstractServer&) {
-        onMessageReceived(event.message);
+    // Without a cache of its own, the resolver uses the one shared by
+    // everyone on the server
+    if (!this->cache) {
+        sharedCache = SharedCache::acquire(server);
+        this->cache = sharedCache->cache();
+        cacheListenerId = sharedCache->addListener([](const Record &) {});
+        sharedCache->addInterest(cacheListenerId, name);
+    }
+
+    listenerId = server->addMessageListener([this](const Message &message) {
+        onMessageReceived(message);
     });
     connect(&timer, &QTimer::timeout, this, &ResolverPrivate::onTimeout);
 
@@ -56,6 +70,15 @@ ResolverPrivate::ResolverPrivate(Resolver *resolver, AbstractServer *server, con
     timer.start(0);
 }
 
+ResolverPrivate::~ResolverPrivate()
+{
+    server->removeMessageListener(listenerId);
+    if (sharedCache) {
+        sharedCache->removeListener(cacheListenerId);
+        SharedCache::release(sharedCache);
+    }
+}
+
 QList<Record> ResolverPrivate::existing() const
 {
     QList<Record> records;
@@ -68,13 +91,22 @@ void ResolverPrivate::query() const
 {
     Message message;
 
-    // Add a query for A and AAAA records
+    // Add a query for A and AAAA records, skipping the types that are
+    // known not to exist; if neither exists, there is nothing to ask for
+    // and failed() is emitted once control returns to the event loop
     Query query;
     query.setName(name);
-    query.setType(A);
-    message.addQuery(query);
-    query.setType(AAAA);
-    message.addQuery(query);
+    if (!cache->hasNegativeEntry(name, A)) {
+        query.setType(A);
+        message.addQuery(query);
+    }
+    if (!cache->hasNegativeEntry(name, AAAA)) {
+        query.setType(AAAA);
+        message.addQuery(query);
+    }
+    if (message.queries().isEmpty()) {
+        return;
+    }
 
     // Add existing (known) records to the query
     const auto records = existing();
@@ -93,7 +125,10 @@ void ResolverPrivate::onMessageReceived(const Message &message)
     }
     const auto records = message.records();
     for (const Record &record : records) {
-        if (record.name() == name && (record.type() == A || record.type() == AAAA)) {
+        if (record.nameAtom() == nameAtom && record.type() == NSEC) {
+            cache->addRecord(record);
+            checkFailed();
+        } else if (record.nameAtom() == nameAtom && (record.type() == A || record.type() == AAAA)) {
             cache->addRecord(record);
             if (!addresses.contains(record.address())) {
                 emit q->resolved(record.address());
@@ -103,12 +138,30 @@ void ResolverPrivate::onMessageReceived(const Message &message)
     }
 }
 
+bool ResolverPrivate::hasNoAddresses() const
+{
+    return cache->hasNegativeEntry(name, A) && cache->hasNegativeEntry(name, AAAA);
+}
+
+void ResolverPrivate::checkFailed()
+{
+    // A host is only given up on if no address was received for it
+    if (!failed && addresses.isEmpty() && hasNoAddresses()) {
+        failed = true;
+        emit q->failed();
+    }
+}
+
 void ResolverPrivate::onTimeout()
 {
     const auto records = existing();
     for (const Record &record : records) {
-        emit q->resolved(record.address());
+        if (!addresses.contains(record.address())) {
+            emit q->resolved(record.address());
+            addresses.insert(record.address());
+        }
     }
+    checkFailed();
 }
 
 Resolver::Resolver(AbstractServer *server, const QByteArray &name, Cache *cache, QObject *parent)
@@ -116,3 +169,39 @@ Resolver::Resolver(AbstractServer *server, const QByteArray &name, Cache *cache,
       d(new ResolverPrivate(this, server, name, cache))
 {
 }
+
+Future<QHostAddress> QMdnsEngine::resolveOnce(AbstractServer *server, const QByteArray &name, int timeout, Cache *cache)
+{
+    Promise<QHostAddress> promise;
+
+    // The resolver belongs to an object owned by the server so that it is
+    // destroyed before the server if the server goes away first, in which
+    // case the future is finished with a null address
+    QObject *owner = new QObject(server->context());
+    BatchResolver *resolver = new BatchResolver(server, cache);
+    QObject::connect(owner, &QObject::destroyed, [promise, resolver] {
+        delete resolver;
+        if (!promise.isFinished()) {
+            promise.finish(QHostAddress());
+        }
+    });
+
+    // The resolver cannot be deleted while it is publishing an event, so
+    // deletion is deferred until control returns to the event loop
+    auto finish = [promise, owner](const QHostAddress &address) {
+        if (!promise.isFinished()) {
+            promise.finish(address);
+            owner->deleteLater();
+        }
+    };
+    resolver->on<HostResolved>([finish](const HostResolved &event, const BatchResolver&) {
+        finish(event.address);
+    });
+    resolver->on<HostTimedOut>([finish](const HostTimedOut&, const BatchResolver&) {
+        finish(QHostAddress());
+    });
+    resolver->setTimeout(timeout);
+    resolver->resolve({name});
+
+    return promise.future();
+}
@@ -30,6 +30,8 @@
 #include <QSet>
 #include <QTimer>
 
+#include <qmdnsengine/nameatom.h>
+
 namespace QMdnsEngine
 {
 
@@ -38,6 +40,7 @@ class Cache;
 class Message;
 class Record;
 class Resolver;
+class SharedCache;
 
 class ResolverPrivate : public QObject
 {
@@ -46,14 +49,22 @@ class ResolverPrivate : public QObject
 public:
 
     explicit ResolverPrivate(Resolver *resolver, AbstractServer *server, const QByteArray &name, Cache *cache);
+    virtual ~ResolverPrivate();
 
     QList<Record> existing() const;
     void query() const;
+    bool hasNoAddresses() const;
+    void checkFailed();
 
     AbstractServer *server;
+    int listenerId;
     QByteArray name;
+    NameAtom nameAtom;
     Cache *cache;
+    SharedCache *sharedCache;
+    int cacheListenerId;
     QSet<QHostAddress> addresses;
+    bool failed;
     QTimer timer;
 
 private Q_SLOTS:
@@ -33,12 +33,17 @@
 #include <QHostAddress>
 #include <QNetworkInterface>
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+#  include <QNetworkDatagram>
+#endif
+
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/server.h>
 
 #include "server_p.h"
+#include "tracing_p.h"
 
 using namespace QMdnsEngine;
 
@@ -70,12 +75,12 @@ bool ServerPrivate::bindSocket(QUdpSocket &socket, const QHostAddress &address)
         int arg = 1;
         if (setsockopt(socket.socketDescriptor(), SOL_SOCKET, SO_REUSEADDR,
                 reinterpret_cast<char*>(&arg), sizeof(int))) {
-            q->publish(Error{strerror(errno)});
+            q->reportError(strerror(errno));
             return false;
         }
 #endif
         if (!socket.bind(address, MdnsPort, QAbstractSocket::ReuseAddressHint)) {
-            q->publish(Error{socket.errorString()});
+            q->reportError(socket.errorString());
             return false;
         }
 #ifdef Q_OS_UNIX
@@ -85,6 +90,20 @@ bool ServerPrivate::bindSocket(QUdpSocket &socket, const QHostAddress &address)
     return true;
 }
 
+void ServerPrivate::writeDatagram(QUdpSocket &socket, const Message &message, const QByteArray &packet,
+                                  const QHostAddress &address, quint16 port)
+{
+    // Only packets that were actually written are recorded
+    qint64 nBytes = socket.writeDatagram(packet, address, port);
+    if (nBytes < 0) {
+        return;
+    }
+
+    // The operating system selects the interface the packet leaves on, so
+    // it is recorded by address family instead
+    q->recordSent(message, &socket == &ipv4Socket ? QStringLiteral("ipv4") : QStringLiteral("ipv6"), nBytes);
+}
+
 void ServerPrivate::onTimeout()
 {
     // A timer is used to run a set of operations once per minute; first, the
@@ -115,18 +134,35 @@ void ServerPrivate::onTimeout()
 
 void ServerPrivate::onReadyRead()
 {
-    // Read the packet from the socket
+    // Read the packet from the socket along with the interface it arrived
+    // on, where available
     QUdpSocket *socket = qobject_cast<QUdpSocket*>(sender());
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    QNetworkDatagram datagram = socket->receiveDatagram();
+    QByteArray packet = datagram.data();
+    QHostAddress address = datagram.senderAddress();
+    quint16 port = datagram.senderPort();
+    QString interfaceName;
+    if (datagram.interfaceIndex()) {
+        interfaceName = QNetworkInterface::interfaceNameFromIndex(datagram.interfaceIndex());
+    }
+#else
     QByteArray packet;
     packet.resize(socket->pendingDatagramSize());
     QHostAddress address;
     quint16 port;
     socket->readDatagram(packet.data(), packet.size(), &address, &port);
+    QString interfaceName;
+#endif
+    q->recordReceived(interfaceName, packet.size());
 
     // Attempt to decode the packet
-    auto message = fromPacket(packet, address, port);
+    ParseError error;
+    auto message = fromPacket(packet, address, port, error);
     if (message) {
-        q->publish(MessageReceived{*message});
+        q->dispatchMessage(*message);
+    } else {
+        q->recordParseError(error);
     }
 }
 
@@ -137,19 +173,23 @@ Server::Server()
 
 void Server::sendMessage(const Message &message)
 {
+    QMDNSENGINE_TRACE(TraceSend);
+
     QByteArray packet;
     toPacket(message, packet);
     if (message.address().protocol() == QAbstractSocket::IPv4Protocol) {
-        d->ipv4Socket.writeDatagram(packet, message.address(), message.port());
+        d->writeDatagram(d->ipv4Socket, message, packet, message.address(), message.port());
     } else {
-        d->ipv6Socket.writeDatagram(packet, message.address(), message.port());
+        d->writeDatagram(d->ipv6Socket, message, packet, message.address(), message.port());
     }
 }
 
 void Server::sendMessageToAll(const Message &message)
 {
+    QMDNSENGINE_TRACE(TraceSend);
+
     QByteArray packet;
     toPacket(message, packet);
-    d->ipv4Socket.writeDatagram(packet, MdnsIpv4Address, MdnsPort);
-    d->ipv6Socket.writeDatagram(packet, MdnsIpv6Address, MdnsPort);
+    d->writeDatagram(d->ipv4Socket, message, packet, MdnsIpv4Address, MdnsPort);
+    d->writeDatagram(d->ipv6Socket, message, packet, MdnsIpv6Address, MdnsPort);
 }
@@ -34,6 +34,7 @@ class QHostAddress;
 namespace QMdnsEngine
 {
 
+class Message;
 class Server;
 
 class ServerPrivate : public QObject
@@ -45,6 +46,8 @@ public:
     explicit ServerPrivate(Server *server);
 
     bool bindSocket(QUdpSocket &socket, const QHostAddress &address);
+    void writeDatagram(QUdpSocket &socket, const Message &message, const QByteArray &packet,
+                       const QHostAddress &address, quint16 port);
 
     QTimer timer;
     QUdpSocket ipv4Socket;
@@ -54,6 +54,7 @@ bool Service::operator==(const Service &other) const
     return d->type == other.d->type &&
         d->name == other.d->name &&
         d->port == other.d->port &&
+        d->addresses == other.d->addresses &&
         d->attributes == other.d->attributes;
 }
 
@@ -97,6 +98,16 @@ void Service::setHostname(const QByteArray &hostname)
     d->hostname = hostname;
 }
 
+QList<QHostAddress> Service::addresses() const
+{
+    return d->addresses;
+}
+
+void Service::setAddresses(const QList<QHostAddress> &addresses)
+{
+    d->addresses = addresses;
+}
+
 quint16 Service::port() const
 {
     return d->port;
@@ -131,6 +142,7 @@ QDebug QMdnsEngine::operator<<(QDebug debug, const Service &service)
         << "Service(name: " << service.name()
         << ", type: " << service.type()
         << ", hostname: " << service.hostname()
+        << ", addresses: " << service.addresses()
         << ", port: " << service.port()
         << ", attributes: " << service.attributes()
         << ")";
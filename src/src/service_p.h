@@ -26,6 +26,8 @@
 #define QMDNSENGINE_SERVICE_P_H
 
 #include <QByteArray>
+#include <QHostAddress>
+#include <QList>
 #include <QMap>
 
 namespace QMdnsEngine
@@ -40,6 +42,7 @@ public:
     QByteArray type;
     QByteArray name;
     QByteArray hostname;
+    QList<QHostAddress> addresses;
     quint16 port;
     QMap<QByteArray, QByteArray> attributes;
 };
@@ -0,0 +1,172 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "refresh_p.h"
+#include "sharedcache_p.h"
+
+using namespace QMdnsEngine;
+
+static QHash<AbstractServer*, SharedCache*> sharedCaches;
+
+SharedCache *SharedCache::acquire(AbstractServer *server)
+{
+    SharedCache *sharedCache = sharedCaches.value(server);
+    if (!sharedCache) {
+        sharedCache = new SharedCache(server);
+        sharedCaches.insert(server, sharedCache);
+    }
+    ++sharedCache->refCount;
+    return sharedCache;
+}
+
+void SharedCache::release(SharedCache *sharedCache)
+{
+    if (!--sharedCache->refCount) {
+        sharedCaches.remove(sharedCache->server);
+        delete sharedCache;
+    }
+}
+
+SharedCache::SharedCache(AbstractServer *server)
+    : server(server),
+      refCount(0),
+      nextListenerId(0)
+{
+    recordCache.on<ShouldQuery>([this](const ShouldQuery &event, const Cache&) {
+        onShouldQuery(event.records);
+    });
+    recordCache.on<RecordExpired>([this](const RecordExpired &event, const Cache&) {
+        onRecordExpired(event.record);
+    });
+
+    purgeTimer.callOnTimeout([this] {
+        onPurgeTimeout();
+    });
+    purgeTimer.setSingleShot(true);
+
+    // Queries are observed once here rather than by each consumer so that
+    // unanswered ones are only counted once
+    listenerId = server->addMessageListener([this](const Message &message) {
+        if (!message.isResponse()) {
+            recordCache.observeQuery(message);
+        }
+    });
+}
+
+SharedCache::~SharedCache()
+{
+    server->removeMessageListener(listenerId);
+}
+
+Cache *SharedCache::cache()
+{
+    return &recordCache;
+}
+
+int SharedCache::addListener(const ExpiredListener &listener)
+{
+    int id = nextListenerId++;
+    listeners.insert(id, listener);
+    return id;
+}
+
+void SharedCache::removeListener(int id)
+{
+    const auto names = listenerInterests.value(id);
+    for (const QByteArray &name : names) {
+        removeInterest(id, name);
+    }
+    listenerInterests.remove(id);
+    listeners.remove(id);
+}
+
+void SharedCache::addInterest(int id, const QByteArray &name)
+{
+    QSet<QByteArray> &names = listenerInterests[id];
+    if (!names.contains(name)) {
+        names.insert(name);
+        ++interests[name];
+    }
+}
+
+void SharedCache::removeInterest(int id, const QByteArray &name)
+{
+    auto i = listenerInterests.find(id);
+    if (i == listenerInterests.end() || !i.value().remove(name)) {
+        return;
+    }
+
+    // Once nobody is interested in the name, its records are freed - this
+    // is deferred since interest is often released while the cache is
+    // publishing an event
+    if (!--interests[name]) {
+        interests.remove(name);
+        unreferenced.insert(name);
+        purgeTimer.start(0);
+    }
+}
+
+void SharedCache::onShouldQuery(const QList<Record> &records)
+{
+    // Only records that someone is still interested in are refreshed - and
+    // only once, no matter how many consumers there are
+
+    QList<Record> wanted;
+    for (const Record &record : records) {
+        if (interests.contains(record.name())) {
+            wanted.append(record);
+        }
+    }
+    if (!wanted.isEmpty()) {
+        sendRefreshQueries(server, &recordCache, wanted);
+    }
+}
+
+void SharedCache::onRecordExpired(const Record &record)
+{
+    // Iterate over a copy since listeners may be removed in the process
+    const auto current = listeners;
+    for (auto i = current.constBegin(); i != current.constEnd(); ++i) {
+        if (listeners.contains(i.key())) {
+            i.value()(record);
+        }
+    }
+}
+
+void SharedCache::onPurgeTimeout()
+{
+    const auto names = unreferenced;
+    unreferenced.clear();
+    for (const QByteArray &name : names) {
+        if (!interests.contains(name)) {
+            recordCache.removeRecords(name, ANY);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_SHAREDCACHE_P_H
+#define QMDNSENGINE_SHAREDCACHE_P_H
+
+#include <functional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QTimer>
+
+#include <qmdnsengine/cache.h>
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Record;
+
+/*
+ * Browsers and resolvers created without a cache share a single one per
+ * server; each of them registers interest in the names it cares about, so
+ * that records are refreshed with a single query regardless of the number
+ * of consumers and are freed once nobody is interested in them anymore
+ */
+class SharedCache
+{
+public:
+
+    typedef std::function<void(const Record &record)> ExpiredListener;
+
+    static SharedCache *acquire(AbstractServer *server);
+    static void release(SharedCache *sharedCache);
+
+    Cache *cache();
+
+    int addListener(const ExpiredListener &listener);
+    void removeListener(int id);
+
+    void addInterest(int id, const QByteArray &name);
+    void removeInterest(int id, const QByteArray &name);
+
+private:
+
+    explicit SharedCache(AbstractServer *server);
+    ~SharedCache();
+
+    void onShouldQuery(const QList<Record> &records);
+    void onRecordExpired(const Record &record);
+    void onPurgeTimeout();
+
+    AbstractServer *server;
+    int listenerId;
+    int refCount;
+    Cache recordCache;
+
+    int nextListenerId;
+    QMap<int, ExpiredListener> listeners;
+    QHash<int, QSet<QByteArray>> listenerInterests;
+    QHash<QByteArray, int> interests;
+
+    QSet<QByteArray> unreferenced;
+    QTimer purgeTimer;
+};
+
+}
+
+#endif // QMDNSENGINE_SHAREDCACHE_P_H
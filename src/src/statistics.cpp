@@ -0,0 +1,194 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QElapsedTimer>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/statistics.h>
+
+using namespace QMdnsEngine;
+
+namespace
+{
+
+const char *parseErrorName(ParseError error)
+{
+    switch (error) {
+    case NoParseError:
+        return "none";
+    case TruncatedHeader:
+        return "truncated_header";
+    case InvalidQuery:
+        return "invalid_query";
+    case InvalidAnswer:
+        return "invalid_answer";
+    case InvalidAuthority:
+        return "invalid_authority";
+    case InvalidAdditional:
+        return "invalid_additional";
+    }
+    return "unknown";
+}
+
+QByteArray escapeLabel(const QString &value)
+{
+    QByteArray escaped = value.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+    return escaped;
+}
+
+void writeMetric(QByteArray &output, const char *name, const char *type, const char *help)
+{
+    output.append("# HELP qmdnsengine_").append(name).append(' ').append(help).append('\n');
+    output.append("# TYPE qmdnsengine_").append(name).append(' ').append(type).append('\n');
+}
+
+void writeValue(QByteArray &output, const char *name, quint64 value, const QByteArray &labels = QByteArray())
+{
+    output.append("qmdnsengine_").append(name);
+    if (!labels.isEmpty()) {
+        output.append('{').append(labels).append('}');
+    }
+    output.append(' ').append(QByteArray::number(value)).append('\n');
+}
+
+double rate(quint64 current, quint64 previous, qint64 elapsed)
+{
+    return elapsed > 0 ? (current - previous) * 1000.0 / elapsed : 0;
+}
+
+}
+
+TrafficStatistics::TrafficStatistics()
+    : packetsReceived(0),
+      bytesReceived(0),
+      packetsSent(0),
+      bytesSent(0)
+{
+}
+
+ServerStatistics::ServerStatistics()
+    : queriesReceived(0),
+      responsesReceived(0),
+      queriesSent(0),
+      responsesSent(0),
+      messageEvents(0),
+      errorEvents(0),
+      listenerCalls(0)
+{
+}
+
+CacheStatistics::CacheStatistics()
+    : size(0),
+      hits(0),
+      misses(0),
+      insertions(0),
+      expirations(0)
+{
+}
+
+StatisticsSnapshot::StatisticsSnapshot()
+    : timestamp(0)
+{
+}
+
+StatisticsSnapshot StatisticsSnapshot::take(const AbstractServer *server, const Cache *cache)
+{
+    StatisticsSnapshot snapshot;
+    snapshot.timestamp = QElapsedTimer::msecsSinceReference();
+    snapshot.server = server->statistics();
+    if (cache) {
+        snapshot.cache = cache->statistics();
+    }
+    return snapshot;
+}
+
+double StatisticsSnapshot::queryRate(const StatisticsSnapshot &previous) const
+{
+    return rate(server.queriesReceived, previous.server.queriesReceived, timestamp - previous.timestamp);
+}
+
+double StatisticsSnapshot::responseRate(const StatisticsSnapshot &previous) const
+{
+    return rate(server.responsesReceived, previous.server.responsesReceived, timestamp - previous.timestamp);
+}
+
+QByteArray StatisticsSnapshot::toPrometheus() const
+{
+    QByteArray output;
+
+    // Traffic is broken down by interface, with packets sent to the
+    // multicast group reported under an empty interface name
+    struct {
+        const char *name;
+        const char *help;
+        quint64 TrafficStatistics::*counter;
+    } const traffic[] = {
+        {"packets_received_total", "Packets received", &TrafficStatistics::packetsReceived},
+        {"bytes_received_total", "Bytes received", &TrafficStatistics::bytesReceived},
+        {"packets_sent_total", "Packets sent", &TrafficStatistics::packetsSent},
+        {"bytes_sent_total", "Bytes sent", &TrafficStatistics::bytesSent}
+    };
+    for (const auto &metric : traffic) {
+        writeMetric(output, metric.name, "counter", metric.help);
+        for (auto i = server.interfaces.constBegin(); i != server.interfaces.constEnd(); ++i) {
+            writeValue(output, metric.name, i.value().*metric.counter,
+                       "interface=\"" + escapeLabel(i.key()) + "\"");
+        }
+    }
+
+    writeMetric(output, "parse_errors_total", "counter", "Packets that could not be parsed");
+    for (auto i = server.parseErrors.constBegin(); i != server.parseErrors.constEnd(); ++i) {
+        writeValue(output, "parse_errors_total", i.value(),
+                   QByteArray("reason=\"") + parseErrorName(i.key()) + "\"");
+    }
+
+    writeMetric(output, "messages_received_total", "counter", "Messages received");
+    writeValue(output, "messages_received_total", server.queriesReceived, "kind=\"query\"");
+    writeValue(output, "messages_received_total", server.responsesReceived, "kind=\"response\"");
+    writeMetric(output, "messages_sent_total", "counter", "Packets containing messages sent");
+    writeValue(output, "messages_sent_total", server.queriesSent, "kind=\"query\"");
+    writeValue(output, "messages_sent_total", server.responsesSent, "kind=\"response\"");
+
+    writeMetric(output, "events_total", "counter", "Events dispatched by the server");
+    writeValue(output, "events_total", server.messageEvents, "event=\"message_received\"");
+    writeValue(output, "events_total", server.errorEvents, "event=\"error\"");
+    writeMetric(output, "listener_calls_total", "counter", "Calls made to message listeners");
+    writeValue(output, "listener_calls_total", server.listenerCalls);
+
+    writeMetric(output, "cache_records", "gauge", "Records in the cache");
+    writeValue(output, "cache_records", cache.size);
+    writeMetric(output, "cache_lookups_total", "counter", "Cache lookups");
+    writeValue(output, "cache_lookups_total", cache.hits, "result=\"hit\"");
+    writeValue(output, "cache_lookups_total", cache.misses, "result=\"miss\"");
+    writeMetric(output, "cache_insertions_total", "counter", "Records added to or refreshed in the cache");
+    writeValue(output, "cache_insertions_total", cache.insertions);
+    writeMetric(output, "cache_expirations_total", "counter", "Records removed from the cache");
+    writeValue(output, "cache_expirations_total", cache.expirations);
+
+    return output;
+}
@@ -0,0 +1,267 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtAlgorithms>
+
+#include <qmdnsengine/tracing.h>
+
+using namespace QMdnsEngine;
+
+namespace
+{
+
+// Values below 32 have their own bucket; above that, each power of two is
+// split into 16 buckets
+const int LinearBuckets = 32;
+const int SubBuckets = 16;
+const int BucketCount = SubBuckets * 60;
+
+int bucketIndex(qint64 value)
+{
+    if (value < LinearBuckets) {
+        return value < 0 ? 0 : static_cast<int>(value);
+    }
+    int shift = 63 - qCountLeadingZeroBits(static_cast<quint64>(value)) - 4;
+    return SubBuckets * shift + static_cast<int>(value >> shift);
+}
+
+qint64 bucketUpperBound(int index)
+{
+    if (index < LinearBuckets) {
+        return index;
+    }
+    int shift = index / SubBuckets - 1;
+    qint64 subBucket = index % SubBuckets + SubBuckets;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+struct TracerState
+{
+    TracerState() : firstEvent(true) {
+        clock.start();
+    }
+
+    QMutex mutex;
+    QElapsedTimer clock;
+    LatencyHistogram histograms[TracePointCount];
+    QFile traceFile;
+    bool firstEvent;
+};
+
+TracerState &tracerState()
+{
+    static TracerState state;
+    return state;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram()
+    : buckets(BucketCount, 0),
+      samples(0),
+      minimum(0),
+      maximum(0),
+      sum(0)
+{
+}
+
+void LatencyHistogram::record(qint64 value)
+{
+    value = qMax<qint64>(value, 0);
+    ++buckets[bucketIndex(value)];
+    minimum = samples ? qMin(minimum, value) : value;
+    maximum = samples ? qMax(maximum, value) : value;
+    sum += value;
+    ++samples;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (!other.samples) {
+        return;
+    }
+    for (int i = 0; i < BucketCount; ++i) {
+        buckets[i] += other.buckets.at(i);
+    }
+    minimum = samples ? qMin(minimum, other.minimum) : other.minimum;
+    maximum = samples ? qMax(maximum, other.maximum) : other.maximum;
+    sum += other.sum;
+    samples += other.samples;
+}
+
+void LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    samples = 0;
+    minimum = 0;
+    maximum = 0;
+    sum = 0;
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return samples;
+}
+
+qint64 LatencyHistogram::min() const
+{
+    return minimum;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return maximum;
+}
+
+double LatencyHistogram::mean() const
+{
+    return samples ? sum / samples : 0;
+}
+
+qint64 LatencyHistogram::percentile(double percentile) const
+{
+    if (!samples) {
+        return 0;
+    }
+    quint64 target = qMax<quint64>(1, static_cast<quint64>(std::ceil(percentile / 100 * samples)));
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        total += buckets.at(i);
+        if (total >= target) {
+            return qBound(minimum, bucketUpperBound(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+bool Tracer::isEnabled()
+{
+#ifdef QMDNSENGINE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+LatencyHistogram Tracer::histogram(TracePoint point)
+{
+    TracerState &state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    return state.histograms[point];
+}
+
+void Tracer::reset()
+{
+    TracerState &state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    for (LatencyHistogram &histogram : state.histograms) {
+        histogram.reset();
+    }
+}
+
+bool Tracer::startChromeTrace(const QString &filename)
+{
+    TracerState &state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    if (state.traceFile.isOpen()) {
+        return false;
+    }
+    state.traceFile.setFileName(filename);
+    if (!state.traceFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    state.traceFile.write("{\"traceEvents\":[");
+    state.firstEvent = true;
+    return true;
+}
+
+void Tracer::stopChromeTrace()
+{
+    TracerState &state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    if (state.traceFile.isOpen()) {
+        state.traceFile.write("\n],\"displayTimeUnit\":\"ns\"}\n");
+        state.traceFile.close();
+    }
+}
+
+void Tracer::record(TracePoint point, qint64 start, qint64 duration, int id)
+{
+    TracerState &state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    state.histograms[point].record(duration);
+
+    // Complete events ("X") carry their start and duration in microseconds
+    if (state.traceFile.isOpen()) {
+        QByteArray event = state.firstEvent ? "\n" : ",\n";
+        event.append("{\"name\":\"").append(name(point))
+             .append("\",\"cat\":\"qmdnsengine\",\"ph\":\"X\",\"ts\":")
+             .append(QByteArray::number(start / 1000.0, 'f', 3))
+             .append(",\"dur\":").append(QByteArray::number(duration / 1000.0, 'f', 3))
+             .append(",\"pid\":").append(QByteArray::number(QCoreApplication::applicationPid()))
+             .append(",\"tid\":").append(QByteArray::number(reinterpret_cast<quintptr>(QThread::currentThreadId())));
+        if (id >= 0) {
+            event.append(",\"args\":{\"id\":").append(QByteArray::number(id)).append('}');
+        }
+        event.append('}');
+        state.traceFile.write(event);
+        state.firstEvent = false;
+    }
+}
+
+qint64 Tracer::now()
+{
+    return tracerState().clock.nsecsElapsed();
+}
+
+const char *Tracer::name(TracePoint point)
+{
+    switch (point) {
+    case TraceDecode:
+        return "decode";
+    case TraceDispatch:
+        return "dispatch";
+    case TraceListener:
+        return "listener";
+    case TraceCacheUpdate:
+        return "cache_update";
+    case TraceEncode:
+        return "encode";
+    case TraceSend:
+        return "send";
+    case TraceRespond:
+        return "respond";
+    case TracePointCount:
+        break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,75 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_TRACING_P_H
+#define QMDNSENGINE_TRACING_P_H
+
+#include <qmdnsengine/tracing.h>
+
+namespace QMdnsEngine
+{
+
+/*
+ * Measures the time until it goes out of scope; only used through the
+ * QMDNSENGINE_TRACE macros so that hooks vanish when tracing is disabled
+ */
+class TraceScope
+{
+public:
+
+    explicit TraceScope(TracePoint point, int id = -1)
+        : point(point),
+          id(id),
+          start(Tracer::now())
+    {
+    }
+
+    ~TraceScope()
+    {
+        Tracer::record(point, start, Tracer::now() - start, id);
+    }
+
+private:
+
+    TracePoint point;
+    int id;
+    qint64 start;
+};
+
+}
+
+#define QMDNSENGINE_TRACE_CONCAT2(a, b) a##b
+#define QMDNSENGINE_TRACE_CONCAT(a, b) QMDNSENGINE_TRACE_CONCAT2(a, b)
+
+#ifdef QMDNSENGINE_TRACING
+#  define QMDNSENGINE_TRACE(point) \
+    QMdnsEngine::TraceScope QMDNSENGINE_TRACE_CONCAT(traceScope, __LINE__)(point)
+#  define QMDNSENGINE_TRACE_ID(point, id) \
+    QMdnsEngine::TraceScope QMDNSENGINE_TRACE_CONCAT(traceScope, __LINE__)(point, id)
+#else
+#  define QMDNSENGINE_TRACE(point) do {} while (false)
+#  define QMDNSENGINE_TRACE_ID(point, id) do {} while (false)
+#endif
+
+#endif // QMDNSENGINE_TRACING_P_H
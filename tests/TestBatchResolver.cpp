@@ -0,0 +1,144 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QList>
+#include <QTest>
+
+#include <qmdnsengine/batchresolver.h>
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/record.h>
+
+#include "common/testserver.h"
+#include "common/util.h"
+
+const QByteArray Name = "test.localhost.";
+const QByteArray Name2 = "test2.localhost.";
+const QHostAddress Address("127.0.0.1");
+
+class TestBatchResolver : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testBatchResolver();
+    void testNegativeResponse();
+};
+
+void TestBatchResolver::testBatchResolver()
+{
+    TestServer server;
+    QMdnsEngine::BatchResolver resolver(&server);
+    resolver.setTimeout(500);
+
+    QList<QByteArray> resolvedNames;
+    QList<QHostAddress> resolvedAddresses;
+    QList<QByteArray> timedOutNames;
+    resolver.on<QMdnsEngine::HostResolved>([&](const QMdnsEngine::HostResolved &event, const QMdnsEngine::BatchResolver&) {
+        resolvedNames.append(event.name);
+        resolvedAddresses.append(event.address);
+    });
+    resolver.on<QMdnsEngine::HostTimedOut>([&](const QMdnsEngine::HostTimedOut &event, const QMdnsEngine::BatchResolver&) {
+        timedOutNames.append(event.name);
+    });
+
+    resolver.resolve({Name, Name2});
+    QCOMPARE(resolver.pendingCount(), 2);
+
+    // The queries for both hosts should be sent in a single packet (over
+    // IPv4 and IPv6)
+    QTRY_VERIFY(queryReceived(&server, Name, QMdnsEngine::A));
+    QVERIFY(queryReceived(&server, Name, QMdnsEngine::AAAA));
+    QCOMPARE(server.receivedMessages().count(), 2);
+    QCOMPARE(server.receivedMessages().at(0).queries().size(), static_cast<size_t>(4));
+
+    // Respond for the first host (twice, to ensure duplicates are ignored)
+    // with the name spelled differently, since names are case-insensitive
+    QMdnsEngine::Record record;
+    record.setName("TEST.localhost.");
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    QCOMPARE(resolvedNames, QList<QByteArray>{Name});
+    QCOMPARE(resolvedAddresses, QList<QHostAddress>{Address});
+    QCOMPARE(resolver.pendingCount(), 1);
+
+    // The second host should time out while the first one should not
+    QTRY_COMPARE(timedOutNames, QList<QByteArray>{Name2});
+    QCOMPARE(resolver.pendingCount(), 0);
+}
+
+void TestBatchResolver::testNegativeResponse()
+{
+    TestServer server;
+    QMdnsEngine::BatchResolver resolver(&server);
+    resolver.setTimeout(60000);
+
+    QList<QByteArray> timedOutNames;
+    resolver.on<QMdnsEngine::HostTimedOut>([&](const QMdnsEngine::HostTimedOut &event, const QMdnsEngine::BatchResolver&) {
+        timedOutNames.append(event.name);
+    });
+
+    resolver.resolve({Name, Name2});
+    QTRY_VERIFY(queryReceived(&server, Name, QMdnsEngine::A));
+
+    // The first host has no addresses at all and the second one has no IPv6
+    // address
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::NSEC);
+    record.setNextDomainName(Name);
+    record.setBitmap(QMdnsEngine::Bitmap());
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setBit(QMdnsEngine::A);
+    record.setName(Name2);
+    record.setNextDomainName(Name2);
+    record.setBitmap(bitmap);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // The first host is given up on long before its timeout
+    QTRY_COMPARE(timedOutNames, QList<QByteArray>{Name});
+    QCOMPARE(resolver.pendingCount(), 1);
+
+    // The second host is only queried for its IPv4 address from now on
+    server.clearReceivedMessages();
+    QTRY_VERIFY(queryReceived(&server, Name2, QMdnsEngine::A));
+    QVERIFY(!queryReceived(&server, Name2, QMdnsEngine::AAAA));
+    QVERIFY(!queryReceived(&server, Name, QMdnsEngine::A));
+}
+
+QTEST_MAIN(TestBatchResolver)
+#include "TestBatchResolver.moc"
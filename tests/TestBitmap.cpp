@@ -0,0 +1,133 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/dns.h>
+
+// The helpers can be evaluated at compile time
+static_assert(QMdnsEngine::Bitmap::windowOf(QMdnsEngine::NSEC) == 0, "");
+static_assert(QMdnsEngine::Bitmap::byteOf(QMdnsEngine::AAAA) == 3, "");
+static_assert(QMdnsEngine::Bitmap::maskOf(QMdnsEngine::A) == 0x40, "");
+
+class TestBitmap : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testBits();
+    void testData();
+    void testWire();
+    void testInvalidWire();
+};
+
+void TestBitmap::testBits()
+{
+    QMdnsEngine::Bitmap bitmap;
+    QVERIFY(bitmap.isEmpty());
+    QCOMPARE(bitmap.wireLength(), 0);
+
+    bitmap.setBit(QMdnsEngine::A);
+    bitmap.setBit(QMdnsEngine::AAAA);
+    QVERIFY(!bitmap.isEmpty());
+    QVERIFY(bitmap.testBit(QMdnsEngine::A));
+    QVERIFY(bitmap.testBit(QMdnsEngine::AAAA));
+    QVERIFY(!bitmap.testBit(QMdnsEngine::TXT));
+    QVERIFY(!bitmap.testBit(QMdnsEngine::NSEC));
+    QCOMPARE(bitmap.length(), static_cast<quint8>(4));
+
+    // Types outside of window 0
+    bitmap.setBit(0x0201);
+    bitmap.setBit(0x0101);
+    bitmap.setBit(0x01ff);
+    QVERIFY(bitmap.testBit(0x0201));
+    QVERIFY(bitmap.testBit(0x0101));
+    QVERIFY(bitmap.testBit(0x01ff));
+    QVERIFY(!bitmap.testBit(0x0301));
+    QVERIFY(!bitmap.testBit(0x0102));
+    QCOMPARE(bitmap.wireLength(), (2 + 4) + (2 + 32) + (2 + 1));
+}
+
+void TestBitmap::testData()
+{
+    const quint8 data[] = { 0x40, 0x00, 0x00, 0x08 };
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setData(sizeof(data), data);
+    QVERIFY(bitmap.testBit(QMdnsEngine::A));
+    QVERIFY(bitmap.testBit(QMdnsEngine::AAAA));
+
+    // Replacing the data clears bits that are no longer included
+    bitmap.setData(1, data);
+    QVERIFY(!bitmap.testBit(QMdnsEngine::AAAA));
+    bitmap.setData(0, nullptr);
+    QVERIFY(bitmap.isEmpty());
+
+    QMdnsEngine::Bitmap other;
+    other.setBit(QMdnsEngine::A);
+    bitmap.setData(1, data);
+    QVERIFY(bitmap == other);
+    QMdnsEngine::Bitmap copy = other;
+    copy.setBit(QMdnsEngine::AAAA);
+    QVERIFY(copy != other);
+}
+
+void TestBitmap::testWire()
+{
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setBit(QMdnsEngine::A);
+    bitmap.setBit(0x0101);
+
+    QByteArray wire;
+    bitmap.toWire(wire);
+    QCOMPARE(wire, QByteArray("\x00\x01\x40\x01\x01\x40", 6));
+    QCOMPARE(wire.length(), bitmap.wireLength());
+
+    QMdnsEngine::Bitmap parsed;
+    QVERIFY(parsed.fromWire(wire.constData(), wire.length()));
+    QVERIFY(parsed == bitmap);
+}
+
+void TestBitmap::testInvalidWire()
+{
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setBit(QMdnsEngine::A);
+
+    // Windows out of order, empty windows, overlong windows and truncated
+    // data are rejected without modifying the bitmap
+    QVERIFY(!bitmap.fromWire("\x01\x01\x40\x00\x01\x40", 6));
+    QVERIFY(!bitmap.fromWire("\x00\x00", 2));
+    QVERIFY(!bitmap.fromWire("\x00\x21", 2));
+    QVERIFY(!bitmap.fromWire("\x00\x02\x40", 3));
+    QVERIFY(!bitmap.fromWire("\x00", 1));
+    QVERIFY(bitmap.testBit(QMdnsEngine::A));
+
+    QVERIFY(bitmap.fromWire("", 0));
+    QVERIFY(bitmap.isEmpty());
+}
+
+QTEST_MAIN(TestBitmap)
+#include "TestBitmap.moc"
@@ -22,10 +22,13 @@
  * IN THE SOFTWARE.
  */
 
-#include <QSignalSpy>
+
+#include <QHostAddress>
 #include <QTest>
+#include <QThread>
 
 #include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
@@ -36,8 +39,6 @@
 #include "common/testserver.h"
 #include "common/util.h"
 
-Q_DECLARE_METATYPE(QMdnsEngine::Service)
-
 const QByteArray Name = "Test";
 const QByteArray Type = "_test._tcp.local.";
 const QByteArray Fqdn = Name + "." + Type;
@@ -45,6 +46,35 @@ const QByteArray Target = "Test.local.";
 const quint16 Port = 1234;
 const QByteArray Key = "key";
 const QByteArray Value = "value";
+const QHostAddress Address("192.168.1.1");
+
+QMdnsEngine::Record createRecord(const QByteArray &name, quint16 type)
+{
+    QMdnsEngine::Record record;
+    record.setName(name);
+    record.setType(type);
+    return record;
+}
+
+void deliverRecords(TestServer *server, const QList<QMdnsEngine::Record> &records)
+{
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (const QMdnsEngine::Record &record : records) {
+        message.addRecord(record);
+    }
+    server->deliverMessage(message);
+}
+
+void deliverService(TestServer *server)
+{
+    QMdnsEngine::Record ptrRecord = createRecord(Type, QMdnsEngine::PTR);
+    ptrRecord.setTarget(Fqdn);
+    QMdnsEngine::Record srvRecord = createRecord(Fqdn, QMdnsEngine::SRV);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+    deliverRecords(server, {ptrRecord, srvRecord});
+}
 
 class TestBrowser : public QObject
 {
@@ -52,24 +82,39 @@ class TestBrowser : public QObject
 
 private Q_SLOTS:
 
-    void initTestCase();
     void testBrowser();
+    void testPtrExpired();
+    void testTxtUpdate();
+    void testAddressFlush();
+    void testAddressFlushSplit();
+    void testResolve();
+    void testBatch();
+    void testBatchResolve();
+    void testSnapshot();
+    void testCacheSnapshot();
+    void testRefreshBatch();
     void testBrowsePtr();
+    void testBrowseSnapshot();
+    void testBrowseSnapshotServerDestroyed();
 };
 
-void TestBrowser::initTestCase()
-{
-    qRegisterMetaType<QMdnsEngine::Service>("Service");
-}
-
 void TestBrowser::testBrowser()
 {
     TestServer server;
     QMdnsEngine::Browser browser(&server, Type);
 
-    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
-    QSignalSpy serviceUpdatedSpy(&browser, SIGNAL(serviceUpdated(Service)));
-    QSignalSpy serviceRemovedSpy(&browser, SIGNAL(serviceRemoved(Service)));
+    int serviceAddedCount = 0;
+    int serviceUpdatedCount = 0;
+    int serviceRemovedCount = 0;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded&, const QMdnsEngine::Browser&) {
+        ++serviceAddedCount;
+    });
+    browser.on<QMdnsEngine::ServiceUpdated>([&](const QMdnsEngine::ServiceUpdated&, const QMdnsEngine::Browser&) {
+        ++serviceUpdatedCount;
+    });
+    browser.on<QMdnsEngine::ServiceRemoved>([&](const QMdnsEngine::ServiceRemoved&, const QMdnsEngine::Browser&) {
+        ++serviceRemovedCount;
+    });
 
     // Wait for the PTR query
     QTRY_VERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
@@ -92,7 +137,7 @@ void TestBrowser::testBrowser()
     server.clearReceivedMessages();
 
     // Nothing should have been added yet
-    QCOMPARE(serviceAddedSpy.count(), 0);
+    QCOMPARE(serviceAddedCount, 0);
 
     // Transmit the SRV record
     {
@@ -107,8 +152,8 @@ void TestBrowser::testBrowser()
         server.deliverMessage(message);
     }
 
-    // The serviceAdded signal should have been emitted
-    QCOMPARE(serviceAddedSpy.count(), 1);
+    // The ServiceAdded event should have been published
+    QCOMPARE(serviceAddedCount, 1);
 
     // Transmit a TXT record
     {
@@ -122,10 +167,10 @@ void TestBrowser::testBrowser()
         server.deliverMessage(message);
     }
 
-    // The serviceAdded signal should NOT have been emitted and the
-    // serviceUpdated signal should have been
-    QCOMPARE(serviceAddedSpy.count(), 1);
-    QCOMPARE(serviceUpdatedSpy.count(), 1);
+    // The ServiceAdded event should NOT have been published again and the
+    // ServiceUpdated event should have been
+    QCOMPARE(serviceAddedCount, 1);
+    QCOMPARE(serviceUpdatedCount, 1);
 
     // Remove the SRV record
     {
@@ -141,20 +186,470 @@ void TestBrowser::testBrowser()
         server.deliverMessage(message);
     }
 
-    // The serviceRemoved signal should have been emitted
-    QCOMPARE(serviceRemovedSpy.count(), 1);
+    // The ServiceRemoved event should have been published
+    QCOMPARE(serviceRemovedCount, 1);
+}
+
+void TestBrowser::testPtrExpired()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    int serviceAddedCount = 0;
+    QList<QMdnsEngine::Service> removedServices;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded&, const QMdnsEngine::Browser&) {
+        ++serviceAddedCount;
+    });
+    browser.on<QMdnsEngine::ServiceRemoved>([&](const QMdnsEngine::ServiceRemoved &event, const QMdnsEngine::Browser&) {
+        removedServices.append(event.service);
+    });
+    deliverService(&server);
+    QCOMPARE(serviceAddedCount, 1);
+
+    // Another querier asks for the PTR record twice without an answer, so
+    // the record is expired and the service goes with it
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    server.deliverMessage(message);
+    QTest::qWait(1100);
+    server.deliverMessage(message);
+
+    QTRY_COMPARE_WITH_TIMEOUT(removedServices.length(), 1, 12000);
+    QCOMPARE(removedServices.at(0).name(), Name);
+    QVERIFY(browser.snapshot().services.isEmpty());
+}
+
+void TestBrowser::testTxtUpdate()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    QList<QMdnsEngine::Service> updatedServices;
+    browser.on<QMdnsEngine::ServiceUpdated>([&](const QMdnsEngine::ServiceUpdated &event, const QMdnsEngine::Browser&) {
+        updatedServices.append(event.service);
+    });
+    deliverService(&server);
+
+    // Each change to the TXT data alone updates the service
+    QMdnsEngine::Record txtRecord = createRecord(Fqdn, QMdnsEngine::TXT);
+    txtRecord.setFlushCache(true);
+    txtRecord.setAttributes({{Key, Value}});
+    deliverRecords(&server, {txtRecord});
+    QCOMPARE(updatedServices.length(), 1);
+    QCOMPARE(updatedServices.at(0).attributes().value(Key), Value);
+
+    // The new data replaces the old one (which was received more than a
+    // second earlier, so it is not part of the new set)
+    QTest::qWait(1100);
+    txtRecord.setAttributes({{Key, "other"}});
+    deliverRecords(&server, {txtRecord});
+    QCOMPARE(updatedServices.length(), 2);
+    QCOMPARE(updatedServices.at(1).attributes().value(Key), QByteArray("other"));
+
+    // Refreshing the same data does not
+    deliverRecords(&server, {txtRecord});
+    QCOMPARE(updatedServices.length(), 2);
+}
+
+void TestBrowser::testAddressFlush()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    QList<QMdnsEngine::Service> updatedServices;
+    browser.on<QMdnsEngine::ServiceUpdated>([&](const QMdnsEngine::ServiceUpdated &event, const QMdnsEngine::Browser&) {
+        updatedServices.append(event.service);
+    });
+    deliverService(&server);
+
+    // Two addresses are added to the set
+    QMdnsEngine::Record record = createRecord(Target, QMdnsEngine::A);
+    record.setAddress(QHostAddress("192.168.1.1"));
+    QMdnsEngine::Record record2 = createRecord(Target, QMdnsEngine::A);
+    record2.setAddress(QHostAddress("192.168.1.2"));
+    deliverRecords(&server, {record, record2});
+    QCOMPARE(updatedServices.length(), 1);
+    QCOMPARE(updatedServices.at(0).addresses().length(), 2);
+
+    // A record with the cache-flush bit replaces the set (the others were
+    // received more than a second earlier, so they are not part of it)
+    QTest::qWait(1100);
+    QMdnsEngine::Record record3 = createRecord(Target, QMdnsEngine::A);
+    record3.setAddress(QHostAddress("192.168.1.3"));
+    record3.setFlushCache(true);
+    deliverRecords(&server, {record3});
+    QCOMPARE(updatedServices.length(), 2);
+    QCOMPARE(updatedServices.at(1).addresses(), QList<QHostAddress>{QHostAddress("192.168.1.3")});
+
+    // The old records expiring from the cache a second later change nothing
+    QTest::qWait(1500);
+    QCOMPARE(updatedServices.length(), 2);
+}
+
+void TestBrowser::testAddressFlushSplit()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    QList<QMdnsEngine::Service> updatedServices;
+    browser.on<QMdnsEngine::ServiceUpdated>([&](const QMdnsEngine::ServiceUpdated &event, const QMdnsEngine::Browser&) {
+        updatedServices.append(event.service);
+    });
+    deliverService(&server);
+
+    // A host announcing its addresses in two packets sets the cache-flush
+    // bit in both; the second packet arrives well within a second, so both
+    // records are part of the new set
+    QMdnsEngine::Record record = createRecord(Target, QMdnsEngine::A);
+    record.setAddress(QHostAddress("192.168.1.1"));
+    record.setFlushCache(true);
+    QMdnsEngine::Record record2 = createRecord(Target, QMdnsEngine::A);
+    record2.setAddress(QHostAddress("192.168.1.2"));
+    record2.setFlushCache(true);
+    deliverRecords(&server, {record});
+    QTest::qWait(50);
+    deliverRecords(&server, {record2});
+    QCOMPARE(updatedServices.length(), 2);
+    QCOMPARE(updatedServices.at(1).addresses().length(), 2);
+
+    // Announcing the same set again soon after does not change anything
+    deliverRecords(&server, {record});
+    deliverRecords(&server, {record2});
+    QCOMPARE(updatedServices.length(), 2);
+}
+
+void TestBrowser::testResolve()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    int serviceAddedCount = 0;
+    QList<QMdnsEngine::Service> resolvedServices;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded&, const QMdnsEngine::Browser&) {
+        ++serviceAddedCount;
+    });
+    browser.on<QMdnsEngine::ServiceResolved>([&](const QMdnsEngine::ServiceResolved &event, const QMdnsEngine::Browser&) {
+        resolvedServices.append(event.service);
+    });
+
+    // Transmit the PTR and SRV records
+    {
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(Fqdn);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(Fqdn);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        message.addRecord(ptrRecord);
+        message.addRecord(srvRecord);
+        server.deliverMessage(message);
+    }
+
+    // The service is added but cannot be connected to yet; the missing
+    // records are queried for in a single message
+    QCOMPARE(serviceAddedCount, 1);
+    QCOMPARE(resolvedServices.length(), 0);
+    QTRY_VERIFY(queryReceived(&server, Target, QMdnsEngine::A));
+    QVERIFY(queryReceived(&server, Target, QMdnsEngine::AAAA));
+    QVERIFY(queryReceived(&server, Fqdn, QMdnsEngine::TXT));
+    QVERIFY(!queryReceived(&server, Fqdn, QMdnsEngine::SRV));
+    int followUpMessages = 0;
+    const auto messages = server.receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (message.queries().length() > 1) {
+            ++followUpMessages;
+        }
+    }
+    QCOMPARE(followUpMessages, 1);
+
+    // Transmit the address of the host
+    {
+        QMdnsEngine::Record record;
+        record.setName(Target);
+        record.setType(QMdnsEngine::A);
+        record.setAddress(Address);
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        message.addRecord(record);
+        server.deliverMessage(message);
+    }
+
+    // The service should now be resolved
+    QCOMPARE(resolvedServices.length(), 1);
+    QCOMPARE(resolvedServices.at(0).addresses(), QList<QHostAddress>{Address});
+    QCOMPARE(resolvedServices.at(0).port(), Port);
+}
+
+void TestBrowser::testBatch()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    browser.setBatchInterval(0);
+
+    int serviceAddedCount = 0;
+    QList<QList<QMdnsEngine::Service>> batches;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded&, const QMdnsEngine::Browser&) {
+        ++serviceAddedCount;
+    });
+    browser.on<QMdnsEngine::ServicesChanged>([&](const QMdnsEngine::ServicesChanged &event, const QMdnsEngine::Browser&) {
+        batches.append(event.added);
+        batches.append(event.updated);
+        batches.append(event.removed);
+    });
+
+    // Transmit three services in a single message
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (int i = 0; i < 3; ++i) {
+        QByteArray fqdn = Name + QByteArray::number(i) + "." + Type;
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(fqdn);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(fqdn);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        message.addRecord(ptrRecord);
+        message.addRecord(srvRecord);
+    }
+    server.deliverMessage(message);
+
+    // The services are reported together once control returns to the event
+    // loop instead of one at a time
+    QCOMPARE(batches.length(), 0);
+    QTRY_COMPARE(batches.length(), 3);
+    QCOMPARE(batches.at(0).length(), 3);
+    QCOMPARE(batches.at(1).length(), 0);
+    QCOMPARE(batches.at(2).length(), 0);
+    QCOMPARE(serviceAddedCount, 0);
+
+    // Update one service and remove another
+    {
+        QMdnsEngine::Record txtRecord;
+        txtRecord.setName(Name + "0." + Type);
+        txtRecord.setType(QMdnsEngine::TXT);
+        txtRecord.setAttributes({{Key, Value}});
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(Name + "1." + Type);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        srvRecord.setTtl(0);
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        message.addRecord(txtRecord);
+        message.addRecord(srvRecord);
+        server.deliverMessage(message);
+    }
+
+    QTRY_COMPARE(batches.length(), 6);
+    QCOMPARE(batches.at(3).length(), 0);
+    QCOMPARE(batches.at(4).length(), 1);
+    QCOMPARE(batches.at(4).at(0).name(), Name + "0");
+    QCOMPARE(batches.at(5).length(), 1);
+    QCOMPARE(batches.at(5).at(0).name(), Name + "1");
+}
+
+void TestBrowser::testBatchResolve()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    browser.setBatchInterval(0);
+
+    QList<QByteArray> events;
+    browser.on<QMdnsEngine::ServicesChanged>([&](const QMdnsEngine::ServicesChanged &event, const QMdnsEngine::Browser&) {
+        if (!event.added.isEmpty()) {
+            events.append("added");
+        }
+    });
+    browser.on<QMdnsEngine::ServiceResolved>([&](const QMdnsEngine::ServiceResolved &event, const QMdnsEngine::Browser&) {
+        QCOMPARE(event.service.addresses(), QList<QHostAddress>{Address});
+        events.append("resolved");
+    });
+
+    // The service and its address arrive together, but the service is only
+    // reported as resolved after the batch that adds it
+    QMdnsEngine::Record addressRecord = createRecord(Target, QMdnsEngine::A);
+    addressRecord.setAddress(Address);
+    deliverService(&server);
+    deliverRecords(&server, {addressRecord});
+    QCOMPARE(events.length(), 0);
+    QTRY_COMPARE(events.length(), 2);
+    QCOMPARE(events, (QList<QByteArray>{"added", "resolved"}));
+}
+
+void TestBrowser::testSnapshot()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    // Transmit two services
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (int i = 0; i < 2; ++i) {
+        QByteArray fqdn = Name + QByteArray::number(i) + "." + Type;
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(fqdn);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(fqdn);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        message.addRecord(ptrRecord);
+        message.addRecord(srvRecord);
+    }
+    server.deliverMessage(message);
+
+    QMdnsEngine::BrowserSnapshot snapshot = browser.snapshot();
+    QCOMPARE(snapshot.services.size(), 2);
+    QVERIFY(snapshot.services.contains(Name + "0." + Type));
+
+    // Update one service and remove the other
+    {
+        QMdnsEngine::Record txtRecord;
+        txtRecord.setName(Name + "0." + Type);
+        txtRecord.setType(QMdnsEngine::TXT);
+        txtRecord.setAttributes({{Key, Value}});
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(Name + "1." + Type);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        srvRecord.setTtl(0);
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        message.addRecord(txtRecord);
+        message.addRecord(srvRecord);
+        server.deliverMessage(message);
+    }
+
+    // The snapshot is unaffected and the changes since it are available
+    QCOMPARE(snapshot.services.size(), 2);
+    QMdnsEngine::ServiceChanges changes = browser.changesSince(snapshot.version);
+    QVERIFY(changes.complete);
+    QCOMPARE(changes.version, snapshot.version + 2);
+    QCOMPARE(changes.added.length(), 0);
+    QCOMPARE(changes.updated.length(), 1);
+    QCOMPARE(changes.updated.at(0).attributes().value(Key), Value);
+    QCOMPARE(changes.removed.length(), 1);
+    QCOMPARE(browser.snapshot().services.size(), 1);
+
+    // Changes since the current version are empty; unknown versions cannot
+    // be brought up to date
+    changes = browser.changesSince(changes.version);
+    QVERIFY(changes.complete);
+    QVERIFY(changes.updated.isEmpty());
+    QVERIFY(!browser.changesSince(changes.version + 1).complete);
+
+    // Changes since the beginning combine into the current state
+    changes = browser.changesSince(0);
+    QVERIFY(changes.complete);
+    QCOMPARE(changes.added.length(), 1);
+    QCOMPARE(changes.removed.length(), 0);
+}
+
+void TestBrowser::testCacheSnapshot()
+{
+    QMdnsEngine::Record ptrRecord = createRecord(Type, QMdnsEngine::PTR);
+    ptrRecord.setTarget(Fqdn);
+    QMdnsEngine::Record srvRecord = createRecord(Fqdn, QMdnsEngine::SRV);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+    QMdnsEngine::Cache savedCache;
+    savedCache.addRecord(ptrRecord);
+    savedCache.addRecord(srvRecord);
+
+    // A browser using a cache restored from a snapshot reports the services
+    // in it without anything being received
+    QMdnsEngine::Cache cache;
+    QVERIFY(cache.loadSnapshot(savedCache.saveSnapshot()));
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type, &cache);
+    QList<QMdnsEngine::Service> addedServices;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded &event, const QMdnsEngine::Browser&) {
+        addedServices.append(event.service);
+    });
+    QTRY_COMPARE(addedServices.length(), 1);
+    QCOMPARE(addedServices.at(0).name(), Name);
+    QCOMPARE(addedServices.at(0).hostname(), Target);
+    QCOMPARE(addedServices.at(0).port(), Port);
+}
+
+void TestBrowser::testRefreshBatch()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    // One service expires soon and the other one does not
+    const QByteArray otherFqdn = Name + "2." + Type;
+    QMdnsEngine::Record ptrRecord = createRecord(Type, QMdnsEngine::PTR);
+    ptrRecord.setTarget(Fqdn);
+    ptrRecord.setTtl(1);
+    QMdnsEngine::Record srvRecord = createRecord(Fqdn, QMdnsEngine::SRV);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+    srvRecord.setTtl(1);
+    QMdnsEngine::Record otherPtrRecord = createRecord(Type, QMdnsEngine::PTR);
+    otherPtrRecord.setTarget(otherFqdn);
+    QMdnsEngine::Record otherSrvRecord = createRecord(otherFqdn, QMdnsEngine::SRV);
+    otherSrvRecord.setTarget(Target);
+    otherSrvRecord.setPort(Port);
+    deliverRecords(&server, {ptrRecord, srvRecord, otherPtrRecord, otherSrvRecord});
+
+    // Block until the first refresh point of both short-lived records has
+    // passed, so that they are due in the same tick of the shared cache
+    QThread::msleep(600);
+
+    // A single packet asks for both of them and lists the record that is
+    // still fresh as a known answer
+    auto refreshSent = [&server, &otherFqdn] {
+        const auto messages = server.receivedMessages();
+        for (const QMdnsEngine::Message &message : messages) {
+            bool ptrQuery = false;
+            bool srvQuery = false;
+            const auto queries = message.queries();
+            for (const QMdnsEngine::Query &query : queries) {
+                ptrQuery |= query.name() == Type && query.type() == QMdnsEngine::PTR;
+                srvQuery |= query.name() == Fqdn && query.type() == QMdnsEngine::SRV;
+            }
+            if (message.isResponse() || !ptrQuery || !srvQuery) {
+                continue;
+            }
+            QList<QByteArray> knownAnswers;
+            const auto records = message.records();
+            for (const QMdnsEngine::Record &record : records) {
+                if (record.type() == QMdnsEngine::PTR) {
+                    knownAnswers.append(record.target());
+                }
+            }
+            return knownAnswers == QList<QByteArray>{otherFqdn};
+        }
+        return false;
+    };
+    QTRY_VERIFY(refreshSent());
 }
 
 void TestBrowser::testBrowsePtr()
 {
     TestServer server;
     QMdnsEngine::Browser browser(&server, QMdnsEngine::MdnsBrowseType);
-    Q_UNUSED(browser);
 
     // Wait for a query for service types
     QTRY_VERIFY(queryReceived(&server, QMdnsEngine::MdnsBrowseType, QMdnsEngine::PTR));
 
-    // Send a PTR and SRV record
+    // Send a PTR record for the service type
     QMdnsEngine::Record record;
     record.setName(QMdnsEngine::MdnsBrowseType);
     record.setType(QMdnsEngine::PTR);
@@ -166,6 +661,63 @@ void TestBrowser::testBrowsePtr()
 
     // Wait for the query for records of the specified type
     QTRY_VERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+    server.clearReceivedMessages();
+
+    // Services of the type are reported by the same browser
+    QList<QMdnsEngine::Service> addedServices;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded &event, const QMdnsEngine::Browser&) {
+        addedServices.append(event.service);
+    });
+    {
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(Fqdn);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(Fqdn);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setTarget(Target);
+        srvRecord.setPort(Port);
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        message.addRecord(ptrRecord);
+        message.addRecord(srvRecord);
+        server.deliverMessage(message);
+    }
+    QCOMPARE(addedServices.length(), 1);
+    QCOMPARE(addedServices.at(0).type(), Type);
+}
+
+void TestBrowser::testBrowseSnapshot()
+{
+    TestServer server;
+    QMdnsEngine::Future<QList<QMdnsEngine::Service>> future = QMdnsEngine::browseSnapshot(&server, Type, 200);
+
+    // Services found during the window are included
+    QTRY_VERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+    deliverService(&server);
+    QVERIFY(!future.isFinished());
+
+    QTRY_VERIFY(future.isFinished());
+    QCOMPARE(future.result().length(), 1);
+    QCOMPARE(future.result().at(0).name(), Name);
+    QCOMPARE(future.result().at(0).port(), Port);
+}
+
+void TestBrowser::testBrowseSnapshotServerDestroyed()
+{
+    TestServer *server = new TestServer;
+    QMdnsEngine::Future<QList<QMdnsEngine::Service>> future = QMdnsEngine::browseSnapshot(server, Type, 200);
+    deliverService(server);
+
+    // The browser goes away with the server and the future is finished
+    // with the services found so far
+    delete server;
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result().length(), 1);
+
+    // Nothing is left to use the server once the window has elapsed
+    QTest::qWait(300);
 }
 
 QTEST_MAIN(TestBrowser)
@@ -22,12 +22,20 @@
  * IN THE SOFTWARE.
  */
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QHostAddress>
 #include <QObject>
-#include <QSignalSpy>
 #include <QTest>
+#include <QThread>
 
+#include <qmdnsengine/bitmap.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/cache.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
 Q_DECLARE_METATYPE(QMdnsEngine::Record)
@@ -47,12 +55,17 @@ private Q_SLOTS:
 
     void initTestCase();
     void testExpiry();
+    void testKnownAnswers();
     void testRemoval();
     void testCacheFlush();
+    void testPassiveObservation();
+    void testNegativeEntries();
+    void testSnapshot();
+    void testConcurrentLookups();
 
 private:
 
-    QMdnsEngine::Record createRecord();
+    QMdnsEngine::Record createRecord(quint32 ttl = 1);
 
     int mCounter;
 };
@@ -66,22 +79,60 @@ void TestCache::testExpiry()
 {
     QMdnsEngine::Cache cache;
     cache.addRecord(createRecord());
+    cache.addRecord(createRecord());
 
-    QSignalSpy shouldQuerySpy(&cache, SIGNAL(shouldQuery(Record)));
-    QSignalSpy recordExpiredSpy(&cache, SIGNAL(recordExpired(Record)));
+    QList<QList<QMdnsEngine::Record>> batches;
+    int recordExpiredCount = 0;
+    cache.on<QMdnsEngine::ShouldQuery>([&](const QMdnsEngine::ShouldQuery &event, const QMdnsEngine::Cache&) {
+        batches.append(event.records);
+    });
+    cache.on<QMdnsEngine::RecordExpired>([&](const QMdnsEngine::RecordExpired&, const QMdnsEngine::Cache&) {
+        ++recordExpiredCount;
+    });
 
     // The record should be in the cache
     QMdnsEngine::Record record;
     QVERIFY(cache.lookupRecord(Name, Type, record));
 
-    // After entering the event loop, the record should be purged when its TTL
-    // expires in 1s
+    // Block until the first query trigger of both records (at 50% of the
+    // TTL plus a random offset of up to 20ms) has passed
+    QThread::msleep(600);
+
+    // After entering the event loop, the records should be purged when their
+    // TTL expires in 1s
     QTRY_VERIFY(!cache.lookupRecord(Name, Type, record));
 
-    // Ensure that the shouldQuery() signal was emitted at least once and the
-    // recordExpired() signal was eventually emitted as well
-    QVERIFY(shouldQuerySpy.count() > 0);
-    QCOMPARE(recordExpiredSpy.count(), 1);
+    // Both records were due in the first tick and are reported together;
+    // the later triggers (85%, 90% and 95%) follow for each record, alone or
+    // together with the other one, and RecordExpired is published for both
+    QVERIFY(!batches.isEmpty());
+    QCOMPARE(batches.at(0).length(), 2);
+    QVERIFY(batches.at(0).at(0) != batches.at(0).at(1));
+    for (const QList<QMdnsEngine::Record> &batch : batches) {
+        QVERIFY(batch.length() == 1 || batch.length() == 2);
+    }
+    QCOMPARE(recordExpiredCount, 2);
+}
+
+void TestCache::testKnownAnswers()
+{
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Record record = createRecord();
+    record.setTtl(120);
+    cache.addRecord(record);
+
+    // A fresh record can be listed as a known answer with its remaining TTL
+    QList<QMdnsEngine::Record> records;
+    QVERIFY(cache.lookupKnownAnswers(Name, Type, records));
+    QCOMPARE(records.length(), 1);
+    QVERIFY(records.at(0).ttl() > 60 && records.at(0).ttl() <= 120);
+
+    // A record with less than half of its TTL remaining is not
+    QMdnsEngine::Cache shortCache;
+    shortCache.addRecord(createRecord());
+    records.clear();
+    QTest::qWait(600);
+    QVERIFY(!shortCache.lookupKnownAnswers(Name, Type, records));
 }
 
 void TestCache::testRemoval()
@@ -90,7 +141,10 @@ void TestCache::testRemoval()
     QMdnsEngine::Record record = createRecord();
     cache.addRecord(record);
 
-    QSignalSpy recordExpiredSpy(&cache, SIGNAL(recordExpired(Record)));
+    int recordExpiredCount = 0;
+    cache.on<QMdnsEngine::RecordExpired>([&](const QMdnsEngine::RecordExpired&, const QMdnsEngine::Cache&) {
+        ++recordExpiredCount;
+    });
 
     // Purge the record from the cache by setting its TTL to 0
     record.setTtl(0);
@@ -98,37 +152,224 @@ void TestCache::testRemoval()
 
     // Verify that the record is gone
     QVERIFY(!cache.lookupRecord(Name, Type, record));
-    QCOMPARE(recordExpiredSpy.count(), 1);
+    QCOMPARE(recordExpiredCount, 1);
 }
 
 void TestCache::testCacheFlush()
 {
     QMdnsEngine::Cache cache;
     for (int i = 0; i < 2; ++i) {
-        cache.addRecord(createRecord());
+        cache.addRecord(createRecord(120));
     }
 
-    QList<QMdnsEngine::Record> records;
-    QVERIFY(cache.lookupRecords(Name, Type, records));
-    QCOMPARE(records.length(), 2);
+    auto count = [&cache]() {
+        QList<QMdnsEngine::Record> records;
+        cache.lookupRecords(Name, Type, records);
+        return records.length();
+    };
+    QCOMPARE(count(), 2);
 
-    // Insert a new record with the cache clear bit set
-    QMdnsEngine::Record record = createRecord();
+    // Records received in the last second belong to the same set as a new
+    // record with the cache flush bit set and are kept
+    QMdnsEngine::Record record = createRecord(120);
     record.setFlushCache(true);
     cache.addRecord(record);
+    QCOMPARE(count(), 3);
 
-    // Confirm that only a single record exists
-    records.clear();
+    // Older records expire one second after another record flushes them
+    QTest::qWait(1100);
+    record = createRecord(120);
+    record.setFlushCache(true);
+    cache.addRecord(record);
+    QCOMPARE(count(), 4);
+    QTRY_COMPARE(count(), 1);
+}
+
+void TestCache::testPassiveObservation()
+{
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Record record = createRecord(120);
+    QMdnsEngine::Record record2 = createRecord(120);
+    cache.addRecord(record);
+    cache.addRecord(record2);
+
+    QList<QMdnsEngine::Record> expired;
+    cache.on<QMdnsEngine::RecordExpired>([&](const QMdnsEngine::RecordExpired &event, const QMdnsEngine::Cache&) {
+        expired.append(event.record);
+    });
+
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(Type);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+
+    // A query listing a record as a known answer does not count for it and
+    // repeated queries within a second only count once
+    QMdnsEngine::Message knownAnswerMessage = message;
+    knownAnswerMessage.addRecord(record);
+    cache.observeQuery(knownAnswerMessage);
+    cache.observeQuery(message);
+    QTest::qWait(1100);
+    cache.observeQuery(message);
+
+    // The second record is refreshed by a response in the meantime, but
+    // the first one remains unanswered and is expired long before its TTL
+    cache.addRecord(record2);
+    QTRY_COMPARE_WITH_TIMEOUT(expired.length(), 1, 12000);
+    QVERIFY(expired.at(0) == record);
+
+    QList<QMdnsEngine::Record> records;
     QVERIFY(cache.lookupRecords(Name, Type, records));
     QCOMPARE(records.length(), 1);
+    QVERIFY(records.at(0) == record2);
+}
+
+void TestCache::testNegativeEntries()
+{
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setBit(QMdnsEngine::A);
+    QMdnsEngine::Record nsecRecord;
+    nsecRecord.setName("host.local.");
+    nsecRecord.setType(QMdnsEngine::NSEC);
+    nsecRecord.setNextDomainName("host.local.");
+    nsecRecord.setBitmap(bitmap);
+    cache.addRecord(nsecRecord);
+
+    // Only types missing from the bitmap are known not to exist
+    QVERIFY(cache.hasNegativeEntry("host.local.", QMdnsEngine::AAAA));
+    QVERIFY(!cache.hasNegativeEntry("host.local.", QMdnsEngine::A));
+    QVERIFY(!cache.hasNegativeEntry("other.local.", QMdnsEngine::AAAA));
+
+    // A cached record takes precedence over the negative entry
+    QMdnsEngine::Record record;
+    record.setName("host.local.");
+    record.setType(QMdnsEngine::AAAA);
+    record.setAddress(QHostAddress("::1"));
+    cache.addRecord(record);
+    QVERIFY(!cache.hasNegativeEntry("host.local.", QMdnsEngine::AAAA));
+}
+
+void TestCache::testSnapshot()
+{
+    QMdnsEngine::Record longRecord;
+    longRecord.setName("long.local.");
+    longRecord.setType(QMdnsEngine::A);
+    longRecord.setTtl(120);
+    longRecord.setAddress(QHostAddress("192.168.1.1"));
+    QMdnsEngine::Record shortRecord;
+    shortRecord.setName("short.local.");
+    shortRecord.setType(QMdnsEngine::A);
+    shortRecord.setTtl(1);
+    shortRecord.setAddress(QHostAddress("192.168.1.2"));
+
+    QMdnsEngine::Record hugeRecord;
+    hugeRecord.setName("huge.local.");
+    hugeRecord.setType(QMdnsEngine::TXT);
+    hugeRecord.setTtl(120);
+    hugeRecord.setTxtData(QByteArray(70000, 'a'));
+
+    QMdnsEngine::Cache cache;
+    cache.addRecord(longRecord);
+    cache.addRecord(shortRecord);
+    cache.addRecord(hugeRecord);
+    QByteArray snapshot = cache.saveSnapshot();
+
+    // Invalid snapshots are rejected without modifying the cache
+    QMdnsEngine::Cache restored;
+    QVERIFY(!restored.loadSnapshot(snapshot.left(20)));
+    QVERIFY(!restored.loadSnapshot(QByteArray("QMDC") + snapshot.mid(4, 1) + '\x7f' + snapshot.mid(6)));
+    QCOMPARE(restored.statistics().size, quint64(0));
+
+    // Once the short record has expired, only the other one is restored,
+    // with the time it has remaining
+    QTest::qWait(1100);
+    QVERIFY(restored.loadSnapshot(snapshot));
+    QMdnsEngine::Record record;
+    QVERIFY(restored.lookupRecord("long.local.", QMdnsEngine::A, record));
+    QCOMPARE(record, longRecord);
+    QVERIFY(!restored.lookupRecord("short.local.", QMdnsEngine::A, record));
+
+    // Records too large for the snapshot are skipped
+    QVERIFY(!restored.lookupRecord("huge.local.", QMdnsEngine::TXT, record));
+
+    QList<QMdnsEngine::Record> records;
+    QVERIFY(restored.lookupKnownAnswers("long.local.", QMdnsEngine::A, records));
+    QVERIFY(records.at(0).ttl() >= 117 && records.at(0).ttl() < 120);
+
+    // Loading the snapshot again replaces the records instead of adding
+    // duplicates
+    QVERIFY(restored.loadSnapshot(snapshot));
+    QCOMPARE(restored.statistics().size, quint64(1));
+}
+
+void TestCache::testConcurrentLookups()
+{
+    QMdnsEngine::Cache cache(QMdnsEngine::Cache::Concurrent);
+
+    // Start threads that continuously look up records while they are being
+    // added, refreshed, removed and expired in this thread
+    std::atomic<bool> stop(false);
+    std::atomic<bool> failed(false);
+    std::atomic<quint64> lookups(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back([&, i] {
+            int n = i;
+            while (!stop) {
+                QByteArray name = "host" + QByteArray::number(n++ % 64) + ".local.";
+                QList<QMdnsEngine::Record> records;
+                if (cache.lookupRecords(name, QMdnsEngine::A, records)) {
+                    for (const QMdnsEngine::Record &record : records) {
+                        if (record.name() != name || record.type() != QMdnsEngine::A) {
+                            failed = true;
+                        }
+                    }
+                }
+                ++lookups;
+                records.clear();
+                cache.lookupKnownAnswers(name, QMdnsEngine::ANY, records);
+                cache.hasNegativeEntry(name, QMdnsEngine::AAAA);
+            }
+        });
+    }
+
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 64; ++i) {
+            QMdnsEngine::Record record;
+            record.setName("host" + QByteArray::number(i) + ".local.");
+            record.setType(QMdnsEngine::A);
+            record.setTtl(i % 2 ? 1 : 120);
+            record.setFlushCache(round % 2);
+            record.setAddress(QHostAddress(quint32(0x0a000000 + round * 64 + i)));
+            cache.addRecord(record);
+        }
+        cache.removeRecords("host" + QByteArray::number(round) + ".local.", QMdnsEngine::ANY);
+        cache.saveSnapshot();
+        QTest::qWait(50);
+    }
+
+    // Let the records with a short TTL expire while the readers are running
+    QTest::qWait(1100);
+
+    stop = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    QVERIFY(!failed);
+    QMdnsEngine::CacheStatistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits + statistics.misses, quint64(lookups));
+    QVERIFY(statistics.expirations > 0);
 }
 
-QMdnsEngine::Record TestCache::createRecord()
+QMdnsEngine::Record TestCache::createRecord(quint32 ttl)
 {
     QMdnsEngine::Record record;
     record.setName(Name);
     record.setType(Type);
-    record.setTtl(1);
+    record.setTtl(ttl);
     record.addAttribute("key", QByteArray::number(mCounter++));
     return record;
 }
@@ -0,0 +1,168 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QSet>
+#include <QTest>
+
+#include <qmdnsengine/domainname.h>
+
+class TestDomainName : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testParse_data();
+    void testParse();
+    void testWire();
+    void testEquality();
+    void testParent();
+    void testSubdomain();
+    void testText();
+};
+
+void TestDomainName::testParse_data()
+{
+    QTest::addColumn<QByteArray>("name");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<int>("labelCount");
+
+    QTest::newRow("null") << QByteArray() << false << 0;
+    QTest::newRow("root") << QByteArray(".") << true << 0;
+    QTest::newRow("empty") << QByteArray("") << true << 0;
+    QTest::newRow("trailing dot") << QByteArray("host.local.") << true << 2;
+    QTest::newRow("no trailing dot") << QByteArray("host.local") << true << 2;
+    QTest::newRow("service") << QByteArray("My Service._http._tcp.local.") << true << 4;
+    QTest::newRow("empty label") << QByteArray("host..local.") << false << 0;
+    QTest::newRow("leading dot") << QByteArray(".local.") << false << 0;
+    QTest::newRow("double trailing dot") << QByteArray("local..") << false << 0;
+    QTest::newRow("long label") << QByteArray(64, 'a') << false << 0;
+    QTest::newRow("max label") << QByteArray(63, 'a') << true << 1;
+}
+
+void TestDomainName::testParse()
+{
+    QFETCH(QByteArray, name);
+    QFETCH(bool, valid);
+    QFETCH(int, labelCount);
+
+    QMdnsEngine::DomainName domainName(name);
+    QCOMPARE(!domainName.isNull(), valid);
+    QCOMPARE(domainName.labelCount(), labelCount);
+}
+
+void TestDomainName::testWire()
+{
+    QMdnsEngine::DomainName name("test.local.");
+    QByteArray wire("\x04test\x05local\x00", 12);
+    QCOMPARE(name.toWire(), wire);
+    QCOMPARE(name.toByteArray(), QByteArray("test.local."));
+    QCOMPARE(name.label(0), QByteArray("test"));
+    QCOMPARE(name.label(1), QByteArray("local"));
+    QCOMPARE(name.label(2), QByteArray());
+
+    QCOMPARE(QMdnsEngine::DomainName::fromWire(wire), name);
+    QVERIFY(QMdnsEngine::DomainName::fromWire(QByteArray("\x04test", 5)).isNull());
+    QVERIFY(QMdnsEngine::DomainName::fromWire(QByteArray("\xc0\x0c", 2)).isNull());
+    QVERIFY(QMdnsEngine::DomainName::fromWire(QByteArray("\x00\x00", 2)).isNull());
+    QVERIFY(QMdnsEngine::DomainName::fromWire(QByteArray("\x00", 1)).isRoot());
+    QCOMPARE(QMdnsEngine::DomainName(".").toByteArray(), QByteArray("."));
+
+    // Names longer than 255 bytes in wire format are rejected
+    QByteArray label(63, 'a');
+    QByteArray longName = label + "." + label + "." + label + "." + label + ".";
+    QVERIFY(QMdnsEngine::DomainName(longName).isNull());
+}
+
+void TestDomainName::testEquality()
+{
+    QMdnsEngine::DomainName a("Test.Local.");
+    QMdnsEngine::DomainName b("test.local");
+    QMdnsEngine::DomainName c("test.example.");
+    QVERIFY(a == b);
+    QVERIFY(a != c);
+    QCOMPARE(a.hash(), b.hash());
+    QVERIFY(a != QMdnsEngine::DomainName());
+    QVERIFY(QMdnsEngine::DomainName() == QMdnsEngine::DomainName());
+
+    // Bytes outside of the ASCII range are compared exactly
+    QVERIFY(QMdnsEngine::DomainName("\xc3\xa4.local.") != QMdnsEngine::DomainName("\xc3\x84.local."));
+
+    QSet<QMdnsEngine::DomainName> names;
+    names.insert(a);
+    QVERIFY(names.contains(b));
+    QVERIFY(!names.contains(c));
+}
+
+void TestDomainName::testParent()
+{
+    QMdnsEngine::DomainName name("My Service._http._tcp.local.");
+    QMdnsEngine::DomainName parent = name.parent();
+    QCOMPARE(parent, QMdnsEngine::DomainName("_HTTP._tcp.local."));
+    QCOMPARE(parent.hash(), QMdnsEngine::DomainName("_http._tcp.local.").hash());
+    QCOMPARE(parent.labelCount(), 3);
+    QCOMPARE(parent.toByteArray(), QByteArray("_http._tcp.local."));
+    QCOMPARE(parent.toWire(), QMdnsEngine::DomainName("_http._tcp.local.").toWire());
+
+    QMdnsEngine::DomainName root = parent.parent().parent().parent();
+    QVERIFY(root.isRoot());
+    QCOMPARE(root, QMdnsEngine::DomainName("."));
+    QVERIFY(root.parent().isNull());
+}
+
+void TestDomainName::testSubdomain()
+{
+    QMdnsEngine::DomainName type("_http._tcp.local.");
+    QMdnsEngine::DomainName service("My Service._HTTP._tcp.local.");
+    QVERIFY(service.isSubdomainOf(type));
+    QVERIFY(!type.isSubdomainOf(service));
+    QVERIFY(!type.isSubdomainOf(type));
+    QVERIFY(!service.isSubdomainOf(QMdnsEngine::DomainName("_ipp._tcp.local.")));
+    QVERIFY(service.isSubdomainOf(QMdnsEngine::DomainName(".")));
+}
+
+void TestDomainName::testText()
+{
+    QMdnsEngine::DomainName type("_http._tcp.local.");
+    QVERIFY(type.matches("_HTTP._tcp.local."));
+    QVERIFY(type.matches("_http._tcp.local"));
+    QVERIFY(!type.matches("_http._tcp.local.."));
+    QVERIFY(!type.matches("_http._tcp"));
+    QVERIFY(!type.matches("x._http._tcp.local."));
+
+    QVERIFY(type.isParentOf("My Service._HTTP._tcp.local."));
+    QVERIFY(type.isParentOf("a.b._http._tcp.local"));
+    QVERIFY(!type.isParentOf("_http._tcp.local."));
+    QVERIFY(!type.isParentOf("._http._tcp.local."));
+    QVERIFY(!type.isParentOf("a.._http._tcp.local."));
+    QVERIFY(!type.isParentOf(".a._http._tcp.local."));
+    QVERIFY(!type.isParentOf("My Service_http._tcp.local."));
+    QVERIFY(!type.isParentOf("My Service._ipp._tcp.local."));
+    QVERIFY(QMdnsEngine::DomainName(".").isParentOf("local."));
+    QVERIFY(!QMdnsEngine::DomainName(".").isParentOf("a..local."));
+}
+
+QTEST_MAIN(TestDomainName)
+#include "TestDomainName.moc"
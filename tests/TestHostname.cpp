@@ -27,6 +27,7 @@
 #include <QSignalSpy>
 #include <QTest>
 
+#include <qmdnsengine/bitmap.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
 #include <qmdnsengine/message.h>
@@ -45,6 +46,7 @@ private Q_SLOTS:
 
     void testAcquire();
     void testAnswer();
+    void testNsec();
 };
 
 void TestHostname::testAcquire()
@@ -105,5 +107,64 @@ void TestHostname::testAnswer()
     QVERIFY(reply.records().count() > 0);
 }
 
+void TestHostname::testNsec()
+{
+    // Find an address on an interface without any IPv6 addresses
+    QHostAddress address;
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        const auto entries = networkInterface.addressEntries();
+        bool hasIpv6 = false;
+        QHostAddress ipv4Address;
+        for (const QNetworkAddressEntry &entry : entries) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv6Protocol) {
+                hasIpv6 = true;
+            } else if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                ipv4Address = entry.ip();
+            }
+        }
+        if (!hasIpv6 && !ipv4Address.isNull()) {
+            address = ipv4Address;
+            break;
+        }
+    }
+    if (address.isNull()) {
+        QSKIP("no IPv4-only interface available");
+    }
+
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QTRY_VERIFY(hostname.isRegistered());
+    server.clearReceivedMessages();
+
+    // Ask for the IPv6 address of the host
+    QMdnsEngine::Query query;
+    query.setName(hostname.hostname());
+    query.setType(QMdnsEngine::AAAA);
+    QMdnsEngine::Message message;
+    message.setAddress(address);
+    message.setPort(Port);
+    message.addQuery(query);
+    server.deliverMessage(message);
+
+    // The reply asserts that the host only has an IPv4 address
+    QTRY_VERIFY(server.receivedMessages().count() > 0);
+    QMdnsEngine::Message reply = server.receivedMessages().at(0);
+    QMdnsEngine::Record nsecRecord;
+    bool found = false;
+    const auto records = reply.records();
+    for (const QMdnsEngine::Record &record : records) {
+        QVERIFY(record.type() != QMdnsEngine::AAAA);
+        if (record.type() == QMdnsEngine::NSEC) {
+            nsecRecord = record;
+            found = true;
+        }
+    }
+    QVERIFY(found);
+    QCOMPARE(nsecRecord.name(), hostname.hostname());
+    QVERIFY(nsecRecord.bitmap().testBit(QMdnsEngine::A));
+    QVERIFY(!nsecRecord.bitmap().testBit(QMdnsEngine::AAAA));
+}
+
 QTEST_MAIN(TestHostname)
 #include "TestHostname.moc"
@@ -0,0 +1,121 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/nameatom.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+class TestNameAtom : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testIntern();
+    void testCase();
+    void testRelease();
+    void testCanonicalize();
+    void testRecord();
+};
+
+void TestNameAtom::testIntern()
+{
+    QMdnsEngine::NameAtom null;
+    QVERIFY(null.isNull());
+    QVERIFY(QMdnsEngine::NameAtom(QByteArray()).isNull());
+
+    QMdnsEngine::NameAtom a("test-intern._http._tcp.local.");
+    QMdnsEngine::NameAtom b("test-intern._http._tcp.local.");
+    QMdnsEngine::NameAtom c("other-intern._http._tcp.local.");
+    QVERIFY(!a.isNull());
+    QVERIFY(a == b);
+    QVERIFY(a != c);
+    QCOMPARE(qHash(a), qHash(b));
+    QVERIFY(QMdnsEngine::NameAtom::find("test-intern._http._tcp.local.") == a);
+    QVERIFY(QMdnsEngine::NameAtom::find("missing._http._tcp.local.").isNull());
+}
+
+void TestNameAtom::testCase()
+{
+    QMdnsEngine::NameAtom a("Test-Case._http._tcp.local.");
+    QMdnsEngine::NameAtom b("test-case._HTTP._tcp.local.");
+    QVERIFY(a == b);
+    QCOMPARE(qHash(a), qHash(b));
+    QCOMPARE(a.hash(), b.hash());
+    QCOMPARE(a.hash(), size_t(qHash(QByteArray("test-case._http._tcp.local."))));
+
+    // Each atom keeps its own spelling
+    QCOMPARE(a.name(), QByteArray("Test-Case._http._tcp.local."));
+    QCOMPARE(b.name(), QByteArray("test-case._HTTP._tcp.local."));
+    QCOMPARE(b.canonicalName(), QByteArray("test-case._http._tcp.local."));
+
+    QMdnsEngine::NameAtom c = QMdnsEngine::NameAtom::find("TEST-CASE._http._tcp.local.");
+    QVERIFY(c == a);
+    QCOMPARE(c.name(), QByteArray("test-case._http._tcp.local."));
+}
+
+void TestNameAtom::testRelease()
+{
+    int size = QMdnsEngine::NameAtom::tableSize();
+    {
+        QMdnsEngine::NameAtom a("test-release.local.");
+        QMdnsEngine::NameAtom b = a;
+        QCOMPARE(QMdnsEngine::NameAtom::tableSize(), size + 1);
+        a = QMdnsEngine::NameAtom();
+        QCOMPARE(QMdnsEngine::NameAtom::tableSize(), size + 1);
+    }
+    QCOMPARE(QMdnsEngine::NameAtom::tableSize(), size);
+    QVERIFY(QMdnsEngine::NameAtom::find("test-release.local.").isNull());
+}
+
+void TestNameAtom::testCanonicalize()
+{
+    QCOMPARE(QMdnsEngine::NameAtom::canonicalize("ABC.Local."), QByteArray("abc.local."));
+    QCOMPARE(QMdnsEngine::NameAtom::canonicalize("abc.local."), QByteArray("abc.local."));
+
+    // Bytes outside of the ASCII range must not be changed
+    QByteArray name("\xc3\x84pfel.local.");
+    QCOMPARE(QMdnsEngine::NameAtom::canonicalize(name), name);
+}
+
+void TestNameAtom::testRecord()
+{
+    QMdnsEngine::Record record;
+    record.setName("Test-Record.local.");
+    record.setType(QMdnsEngine::A);
+    QCOMPARE(record.name(), QByteArray("Test-Record.local."));
+
+    QMdnsEngine::Query query;
+    query.setName("test-record.LOCAL.");
+    QVERIFY(query.nameAtom() == record.nameAtom());
+    QCOMPARE(query.name(), QByteArray("test-record.LOCAL."));
+    QCOMPARE(record.name(), QByteArray("Test-Record.local."));
+}
+
+QTEST_MAIN(TestNameAtom)
+#include "TestNameAtom.moc"
@@ -22,18 +22,22 @@
  * IN THE SOFTWARE.
  */
 
+#include <QElapsedTimer>
 #include <QSignalSpy>
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/prober.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
 #include "common/testserver.h"
 
 const QByteArray Name = "Test._http._tcp.local.";
+const QByteArray Name2 = "Test2._http._tcp.local.";
 const quint16 Type = QMdnsEngine::SRV;
+const QByteArray Target = "test.local.";
 
 class TestProber : public QObject
 {
@@ -42,6 +46,8 @@ class TestProber : public QObject
 private Q_SLOTS:
 
     void testProbe();
+    void testBatch();
+    void testTiebreak();
 };
 
 void TestProber::testProbe()
@@ -65,5 +71,69 @@ void TestProber::testProbe()
     QVERIFY(nameConfirmedSpy.at(0).at(0).toByteArray() != Name);
 }
 
+void TestProber::testBatch()
+{
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(Type);
+    QMdnsEngine::Record record2;
+    record2.setName(Name2);
+    record2.setType(Type);
+
+    TestServer server;
+    QMdnsEngine::Prober prober(&server, record);
+    QMdnsEngine::Prober prober2(&server, record2);
+    QSignalSpy nameConfirmedSpy(&prober, SIGNAL(nameConfirmed(QByteArray)));
+    QSignalSpy nameConfirmedSpy2(&prober2, SIGNAL(nameConfirmed(QByteArray)));
+
+    // Both names should be confirmed without any change
+    QTRY_COMPARE(nameConfirmedSpy.count(), 1);
+    QTRY_COMPARE(nameConfirmedSpy2.count(), 1);
+    QCOMPARE(nameConfirmedSpy.at(0).at(0).toByteArray(), Name);
+    QCOMPARE(nameConfirmedSpy2.at(0).at(0).toByteArray(), Name2);
+
+    // Three probes should have been sent (over IPv4 and IPv6), each one
+    // containing a query and authority record for both names
+    const auto messages = server.receivedMessages();
+    QCOMPARE(messages.count(), 6);
+    for (const QMdnsEngine::Message &message : messages) {
+        QCOMPARE(message.queries().size(), static_cast<size_t>(2));
+        QCOMPARE(message.authorityRecords().size(), static_cast<size_t>(2));
+    }
+}
+
+void TestProber::testTiebreak()
+{
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(Type);
+    record.setTarget(Target);
+    record.setPort(1);
+
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+
+    TestServer server;
+    QMdnsEngine::Prober prober(&server, record);
+    QSignalSpy nameConfirmedSpy(&prober, SIGNAL(nameConfirmed(QByteArray)));
+
+    // Simulate a simultaneous probe from another host with a record that is
+    // lexicographically later (higher port)
+    QMdnsEngine::Record otherRecord = record;
+    otherRecord.setPort(2);
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::ANY);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    message.addAuthorityRecord(otherRecord);
+    server.deliverMessage(message);
+
+    // The name is kept but probing is deferred by a second
+    QTRY_COMPARE(nameConfirmedSpy.count(), 1);
+    QCOMPARE(nameConfirmedSpy.at(0).at(0).toByteArray(), Name);
+    QVERIFY(elapsedTimer.elapsed() >= 1000);
+}
+
 QTEST_MAIN(TestProber)
 #include "TestProber.moc"
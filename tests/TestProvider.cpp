@@ -26,7 +26,9 @@
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
+#include <qmdnsengine/message.h>
 #include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
 
@@ -35,6 +37,8 @@
 const QByteArray Name = "Test";
 const QByteArray Type = "_test._tcp.local.";
 const QByteArray Fqdn = Name + "." + Type;
+const QByteArray Name2 = "Test2";
+const QByteArray Fqdn2 = Name2 + "." + Type;
 const quint16 Port = 1234;
 const QByteArray Key = "key";
 const QByteArray Value = "value";
@@ -46,6 +50,8 @@ class TestProvider : public QObject
 private Q_SLOTS:
 
     void testProvider();
+    void testAnnouncements();
+    void testNegativeResponse();
 };
 
 void TestProvider::testProvider()
@@ -73,5 +79,76 @@ void TestProvider::testProvider()
     QCOMPARE(record.attributes(), service.attributes());
 }
 
+void TestProvider::testAnnouncements()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+    QMdnsEngine::Provider provider2(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+    service.setName(Name2);
+    provider2.update(service);
+
+    // Count the responses that announce both services at once
+    auto countCombined = [&server]() {
+        int count = 0;
+        const auto messages = server.receivedMessages();
+        for (const QMdnsEngine::Message &message : messages) {
+            bool first = false;
+            bool second = false;
+            const auto records = message.records();
+            for (const QMdnsEngine::Record &record : records) {
+                if (record.type() == QMdnsEngine::SRV) {
+                    first = first || record.name() == Fqdn;
+                    second = second || record.name() == Fqdn2;
+                }
+            }
+            if (message.isResponse() && first && second) {
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    // Both services should be announced in the same packets and each
+    // announcement repeated (3 times, on each protocol)
+    QTRY_COMPARE_WITH_TIMEOUT(countCombined(), 6, 10000);
+}
+
+void TestProvider::testNegativeResponse()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+
+    // A query for a type the service does not have is answered with an
+    // NSEC record listing the types it does have
+    QMdnsEngine::Query query;
+    query.setName(Fqdn);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    server.deliverMessage(message);
+
+    QTRY_VERIFY(server.cache()->hasNegativeEntry(Fqdn, QMdnsEngine::A));
+    QVERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::NSEC, record));
+    QVERIFY(record.bitmap().testBit(QMdnsEngine::SRV));
+    QVERIFY(record.bitmap().testBit(QMdnsEngine::TXT));
+}
+
 QTEST_MAIN(TestProvider)
 #include "TestProvider.moc"
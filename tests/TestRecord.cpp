@@ -0,0 +1,171 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/record.h>
+
+class TestRecord : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testAddress();
+    void testService();
+    void testAttributes();
+    void testTxtData();
+    void testNsec();
+    void testEquality();
+};
+
+void TestRecord::testAddress()
+{
+    QMdnsEngine::Record record;
+    record.setType(QMdnsEngine::A);
+    QCOMPARE(record.address(), QHostAddress());
+    record.setAddress(QHostAddress("192.168.1.1"));
+    QCOMPARE(record.address(), QHostAddress("192.168.1.1"));
+    QCOMPARE(record.target(), QByteArray());
+    QCOMPARE(record.port(), static_cast<quint16>(0));
+
+    record.setAddress(QHostAddress("2001:db8::1"));
+    QCOMPARE(record.address(), QHostAddress("2001:db8::1"));
+
+    // Scope IDs are preserved
+    QHostAddress scoped("fe80::1");
+    scoped.setScopeId("eth0");
+    record.setAddress(scoped);
+    QCOMPARE(record.address().scopeId(), QString("eth0"));
+
+    record.setAddress(QHostAddress());
+    QVERIFY(record.address().isNull());
+}
+
+void TestRecord::testService()
+{
+    // The target may be set before or after the other fields
+    QMdnsEngine::Record record;
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget("host.local.");
+    record.setPriority(1);
+    record.setWeight(2);
+    record.setPort(1234);
+    QCOMPARE(record.target(), QByteArray("host.local."));
+    QCOMPARE(record.priority(), static_cast<quint16>(1));
+    QCOMPARE(record.weight(), static_cast<quint16>(2));
+    QCOMPARE(record.port(), static_cast<quint16>(1234));
+    record.setTarget("other.local.");
+    QCOMPARE(record.target(), QByteArray("other.local."));
+    QCOMPARE(record.port(), static_cast<quint16>(1234));
+    QVERIFY(record.address().isNull());
+}
+
+void TestRecord::testAttributes()
+{
+    QMdnsEngine::Record record;
+    record.setType(QMdnsEngine::TXT);
+    record.addAttribute("a", "1");
+    record.addAttribute("b", QByteArray());
+    QMap<QByteArray, QByteArray> attributes{{"a", "1"}, {"b", QByteArray()}};
+    QCOMPARE(record.attributes(), attributes);
+    QCOMPARE(record.target(), QByteArray());
+
+    // New keys are appended and existing ones replaced
+    record.addAttribute("ab", "2");
+    QCOMPARE(record.txtData(), QByteArray("\x03""a=1""\x01""b""\x04""ab=2", 11));
+    record.addAttribute("a", "3");
+    QCOMPARE(record.txtData(), QByteArray("\x03""a=3""\x04""ab=2""\x01""b", 11));
+}
+
+void TestRecord::testTxtData()
+{
+    // Duplicate keys only use the first value and strings without a key
+    // are ignored
+    QByteArray txtData("\x03""b=2""\x01""a""\x03""b=3""\x00""\x02""=x", 14);
+    QMdnsEngine::Record record;
+    record.setType(QMdnsEngine::TXT);
+    record.setTxtData(txtData);
+    QCOMPARE(record.txtData(), txtData);
+    QMap<QByteArray, QByteArray> attributes{{"a", QByteArray()}, {"b", "2"}};
+    QCOMPARE(record.attributes(), attributes);
+    QVERIFY(record.attributes().value("a").isNull());
+
+    // The map is only built once and shared by every call
+    QVERIFY(record.attributes().isSharedWith(record.attributes()));
+
+    // Attributes are written sorted by key
+    QMdnsEngine::Record other;
+    other.setType(QMdnsEngine::TXT);
+    other.setAttributes(attributes);
+    QCOMPARE(other.txtData(), QByteArray("\x01""a""\x03""b=2", 6));
+    QVERIFY(other != record);
+    other.setTxtData(txtData);
+    QVERIFY(other == record);
+}
+
+void TestRecord::testNsec()
+{
+    quint8 data[] = { 0x40, 0x00, 0x00, 0x08 };
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setData(sizeof(data), data);
+
+    QMdnsEngine::Record record;
+    record.setType(QMdnsEngine::NSEC);
+    record.setNextDomainName("host.local.");
+    record.setBitmap(bitmap);
+
+    // Modifying a copy must not affect the original
+    QMdnsEngine::Record copy = record;
+    QVERIFY(copy == record);
+    copy.setNextDomainName("other.local.");
+    QCOMPARE(record.nextDomainName(), QByteArray("host.local."));
+    QCOMPARE(copy.nextDomainName(), QByteArray("other.local."));
+    QVERIFY(copy.bitmap() == bitmap);
+    QVERIFY(copy != record);
+}
+
+void TestRecord::testEquality()
+{
+    QMdnsEngine::Record a;
+    a.setName("host.local.");
+    a.setType(QMdnsEngine::A);
+    a.setAddress(QHostAddress("10.0.0.1"));
+    a.setTtl(120);
+
+    // The TTL is not compared
+    QMdnsEngine::Record b = a;
+    b.setTtl(60);
+    QVERIFY(a == b);
+
+    b.setAddress(QHostAddress("10.0.0.2"));
+    QVERIFY(a != b);
+}
+
+QTEST_MAIN(TestRecord)
+#include "TestRecord.moc"
@@ -0,0 +1,272 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QHostAddress>
+#include <QObject>
+#include <QTest>
+#include <QtEndian>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/record.h>
+
+#include "common/pcap.h"
+#include "common/replayserver.h"
+
+const QByteArray Type = "_test._tcp.local.";
+const QHostAddress Ipv4Address("192.168.1.2");
+const QHostAddress Ipv6Address("fe80::2");
+
+class TestReplay : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testPcap();
+    void testPcapng();
+    void testReplay();
+    void testTiming();
+
+private:
+
+    QByteArray serviceResponse(int index);
+    QByteArray ipv4Frame(const QByteArray &payload, quint16 port);
+    QByteArray ipv6Packet(const QByteArray &payload);
+    QByteArray pcap(const QList<QByteArray> &frames, qint64 interval);
+};
+
+void TestReplay::testPcap()
+{
+    QByteArray capture = pcap({
+        ipv4Frame(serviceResponse(0), 5353),
+        ipv4Frame(serviceResponse(1), 53),
+        ipv4Frame(serviceResponse(2), 5353)
+    }, 250000);
+
+    // The DNS datagram on port 53 is not part of the mDNS traffic
+    QList<PcapDatagram> datagrams;
+    QString error;
+    QVERIFY(parseCapture(capture, datagrams, error));
+    QCOMPARE(datagrams.length(), 2);
+    QCOMPARE(datagrams.at(0).address, Ipv4Address);
+    QCOMPARE(datagrams.at(0).port, static_cast<quint16>(5353));
+    QCOMPARE(datagrams.at(0).payload, serviceResponse(0));
+    QCOMPARE(datagrams.at(1).timestamp - datagrams.at(0).timestamp, static_cast<qint64>(500000));
+
+    // A truncated capture still yields the complete frames
+    datagrams.clear();
+    QVERIFY(parseCapture(capture.left(capture.length() - 10), datagrams, error));
+    QCOMPARE(datagrams.length(), 1);
+
+    // So does one with a length that runs past the end of the data
+    QByteArray corrupt = capture;
+    qToLittleEndian<quint32>(0x7fffffff, corrupt.data() + 32);
+    datagrams.clear();
+    QVERIFY(parseCapture(corrupt, datagrams, error));
+    QCOMPARE(datagrams.length(), 0);
+
+    // Anything else is rejected
+    QVERIFY(!parseCapture("not a capture at all", datagrams, error));
+}
+
+void TestReplay::testPcapng()
+{
+    QByteArray capture;
+    QDataStream stream(&capture, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // Section header block
+    stream << quint32(0x0a0d0d0a) << quint32(28) << quint32(0x1a2b3c4d)
+           << quint16(1) << quint16(0) << qint64(-1) << quint32(28);
+
+    // Interface description block for raw IP with nanosecond timestamps
+    stream << quint32(1) << quint32(32) << quint16(101) << quint16(0) << quint32(0)
+           << quint16(9) << quint16(1) << quint8(9) << quint8(0) << quint16(0)
+           << quint16(0) << quint16(0) << quint32(32);
+
+    // Enhanced packet blocks
+    for (int i = 0; i < 2; ++i) {
+        QByteArray packet = ipv6Packet(serviceResponse(i));
+        int padding = (4 - packet.length() % 4) % 4;
+        quint32 length = 32 + packet.length() + padding;
+        quint64 timestamp = 1000000000ull * (i + 1) + 1500;
+        stream << quint32(6) << length << quint32(0)
+               << quint32(timestamp >> 32) << quint32(timestamp & 0xffffffff)
+               << quint32(packet.length()) << quint32(packet.length());
+        stream.writeRawData(packet.constData(), packet.length());
+        stream.writeRawData("\0\0\0", padding);
+        stream << length;
+    }
+
+    QList<PcapDatagram> datagrams;
+    QString error;
+    QVERIFY(parseCapture(capture, datagrams, error));
+    QCOMPARE(datagrams.length(), 2);
+    QCOMPARE(datagrams.at(0).address, Ipv6Address);
+    QCOMPARE(datagrams.at(1).payload, serviceResponse(1));
+    QCOMPARE(datagrams.at(0).timestamp, static_cast<qint64>(1000001));
+    QCOMPARE(datagrams.at(1).timestamp, static_cast<qint64>(2000001));
+
+    // Timestamps finer than nanoseconds are rejected
+    capture[48] = 10;
+    QVERIFY(!parseCapture(capture, datagrams, error));
+}
+
+void TestReplay::testReplay()
+{
+    const int Count = 20;
+    QList<QByteArray> frames;
+    for (int i = 0; i < Count; ++i) {
+        frames.append(ipv4Frame(serviceResponse(i), 5353));
+    }
+    frames.append(ipv4Frame("garbage", 5353));
+
+    QList<PcapDatagram> datagrams;
+    QString error;
+    QVERIFY(parseCapture(pcap(frames, 1000), datagrams, error));
+
+    ReplayServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    int servicesAdded = 0;
+    browser.on<QMdnsEngine::ServiceAdded>([&](const QMdnsEngine::ServiceAdded&, const QMdnsEngine::Browser&) {
+        ++servicesAdded;
+    });
+
+    ReplayStats stats = server.replay(datagrams);
+    QCOMPARE(servicesAdded, Count);
+    QCOMPARE(stats.datagrams, Count + 1);
+    QCOMPARE(stats.parseErrors, 1);
+    QCOMPARE(stats.latencies.length(), Count + 1);
+    QVERIFY(stats.latencyPercentile(50) <= stats.latencyPercentile(99));
+    QVERIFY(stats.messagesPerSecond() > 0);
+}
+
+void TestReplay::testTiming()
+{
+    QList<QByteArray> frames;
+    for (int i = 0; i < 5; ++i) {
+        frames.append(ipv4Frame(serviceResponse(i), 5353));
+    }
+
+    QList<PcapDatagram> datagrams;
+    QString error;
+    QVERIFY(parseCapture(pcap(frames, 100000), datagrams, error));
+
+    // The capture spans 400 ms, which takes 40 ms at ten times the speed
+    ReplayServer server;
+    ReplayStats stats = server.replay(datagrams, 10);
+    QVERIFY(stats.wallTime >= 35000000);
+    QVERIFY(stats.wallTime < 400000000);
+}
+
+QByteArray TestReplay::serviceResponse(int index)
+{
+    QByteArray fqName = "Test " + QByteArray::number(index) + "." + Type;
+
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Type);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTtl(120);
+    ptrRecord.setTarget(fqName);
+
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(fqName);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setTtl(120);
+    srvRecord.setTarget("test.local.");
+    srvRecord.setPort(1234);
+
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+    return packet;
+}
+
+QByteArray TestReplay::ipv4Frame(const QByteArray &payload, quint16 port)
+{
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+
+    // Ethernet header
+    stream << quint8(0x01) << quint8(0x00) << quint8(0x5e) << quint8(0x00) << quint8(0x00) << quint8(0xfb)
+           << quint8(0x02) << quint8(0x00) << quint8(0x00) << quint8(0x00) << quint8(0x00) << quint8(0x02)
+           << quint16(0x0800);
+
+    // IPv4 header (the checksum is not verified)
+    stream << quint8(0x45) << quint8(0) << quint16(28 + payload.length())
+           << quint16(0) << quint16(0) << quint8(255) << quint8(17) << quint16(0)
+           << Ipv4Address.toIPv4Address() << QHostAddress("224.0.0.251").toIPv4Address();
+
+    // UDP header
+    stream << port << port << quint16(8 + payload.length()) << quint16(0);
+    stream.writeRawData(payload.constData(), payload.length());
+    return frame;
+}
+
+QByteArray TestReplay::ipv6Packet(const QByteArray &payload)
+{
+    QByteArray packet;
+    QDataStream stream(&packet, QIODevice::WriteOnly);
+
+    stream << quint32(0x60000000) << quint16(8 + payload.length()) << quint8(17) << quint8(255);
+    Q_IPV6ADDR source = Ipv6Address.toIPv6Address();
+    stream.writeRawData(reinterpret_cast<const char*>(source.c), 16);
+    Q_IPV6ADDR destination = QHostAddress("ff02::fb").toIPv6Address();
+    stream.writeRawData(reinterpret_cast<const char*>(destination.c), 16);
+
+    stream << quint16(5353) << quint16(5353) << quint16(8 + payload.length()) << quint16(0);
+    stream.writeRawData(payload.constData(), payload.length());
+    return packet;
+}
+
+QByteArray TestReplay::pcap(const QList<QByteArray> &frames, qint64 interval)
+{
+    QByteArray capture;
+    QDataStream stream(&capture, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // Global header for Ethernet with microsecond timestamps
+    stream << quint32(0xa1b2c3d4) << quint16(2) << quint16(4) << qint32(0)
+           << quint32(0) << quint32(65535) << quint32(1);
+
+    qint64 timestamp = 1500000000000000;
+    for (const QByteArray &frame : frames) {
+        stream << quint32(timestamp / 1000000) << quint32(timestamp % 1000000)
+               << quint32(frame.length()) << quint32(frame.length());
+        stream.writeRawData(frame.constData(), frame.length());
+        timestamp += interval;
+    }
+    return capture;
+}
+
+QTEST_MAIN(TestReplay)
+#include "TestReplay.moc"
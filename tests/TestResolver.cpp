@@ -26,6 +26,7 @@
 #include <QSignalSpy>
 #include <QTest>
 
+#include <qmdnsengine/bitmap.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/record.h>
@@ -47,6 +48,11 @@ private Q_SLOTS:
 
     void initTestCase();
     void testResolver();
+    void testFailed();
+    void testResolveOnce();
+    void testResolveOnceTimeout();
+    void testResolveOnceServerDestroyed();
+    void testSharedCache();
 };
 
 void TestResolver::initTestCase()
@@ -80,5 +86,109 @@ void TestResolver::testResolver()
     QCOMPARE(resolvedSpy.at(0).at(0).value<QHostAddress>(), Address);
 }
 
+void TestResolver::testFailed()
+{
+    TestServer server;
+    QMdnsEngine::Resolver resolver(&server, Name);
+    QSignalSpy failedSpy(&resolver, SIGNAL(failed()));
+    QTRY_VERIFY(queryReceived(&server, Name, QMdnsEngine::A));
+
+    // A negative response (with the name spelled differently) shows that
+    // the host has no addresses at all
+    QMdnsEngine::Record record;
+    record.setName("TEST.localhost.");
+    record.setType(QMdnsEngine::NSEC);
+    record.setNextDomainName(Name);
+    record.setBitmap(QMdnsEngine::Bitmap());
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QCOMPARE(failedSpy.count(), 1);
+
+    // A new resolver does not query for the host and fails right away
+    server.clearReceivedMessages();
+    QMdnsEngine::Resolver resolver2(&server, Name);
+    QSignalSpy failedSpy2(&resolver2, SIGNAL(failed()));
+    QTRY_COMPARE(failedSpy2.count(), 1);
+    QCOMPARE(server.receivedMessages().count(), 0);
+}
+
+void TestResolver::testResolveOnce()
+{
+    TestServer server;
+    QMdnsEngine::Future<QHostAddress> future = QMdnsEngine::resolveOnce(&server, Name, 1000);
+    QHostAddress result;
+    future.then([&result](const QHostAddress &address) {
+        result = address;
+    });
+
+    // Wait for the query and then reply to it
+    QTRY_VERIFY(queryReceived(&server, Name, QMdnsEngine::A));
+    QVERIFY(!future.isFinished());
+
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // The future should be finished immediately
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result(), Address);
+    QCOMPARE(result, Address);
+}
+
+void TestResolver::testResolveOnceTimeout()
+{
+    TestServer server;
+    QMdnsEngine::Future<QHostAddress> future = QMdnsEngine::resolveOnce(&server, Name, 100);
+
+    // Without a reply, the future finishes with a null address
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(future.result().isNull());
+}
+
+void TestResolver::testResolveOnceServerDestroyed()
+{
+    TestServer *server = new TestServer;
+    QMdnsEngine::Future<QHostAddress> future = QMdnsEngine::resolveOnce(server, Name, 1000);
+
+    // The resolver goes away with the server and the future is finished
+    delete server;
+    QVERIFY(future.isFinished());
+    QVERIFY(future.result().isNull());
+
+    // Nothing is left to use the server once the timeout has elapsed
+    QTest::qWait(1100);
+}
+
+void TestResolver::testSharedCache()
+{
+    TestServer server;
+    QMdnsEngine::Resolver resolver(&server, Name);
+    QMdnsEngine::Resolver resolver2(&server, Name);
+
+    // Send a record that must be refreshed soon
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    record.setTtl(1);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    server.clearReceivedMessages();
+
+    // Both resolvers share the cache, so only a single refresh query should
+    // be sent (over IPv4 and IPv6)
+    QTRY_VERIFY(queryReceived(&server, Name, QMdnsEngine::A));
+    QCOMPARE(server.receivedMessages().count(), 2);
+}
+
 QTEST_MAIN(TestResolver)
 #include "TestResolver.moc"
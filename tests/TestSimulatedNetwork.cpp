@@ -0,0 +1,210 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QSet>
+#include <QTest>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/hostname.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/service.h>
+
+#include "common/simulatednetwork.h"
+
+const QByteArray Type = "_sim._tcp.local.";
+
+class TestSimulatedNetwork : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testDelivery();
+    void testLinkEffects();
+    void testScale();
+
+private:
+
+    QMdnsEngine::Message query(const QByteArray &name);
+    int envValue(const char *name, int defaultValue);
+};
+
+void TestSimulatedNetwork::testDelivery()
+{
+    SimulatedNetwork network;
+    network.setDefaultLink({50, 0, 0, 0, 1500});
+    SimulatedServer *sender = network.addEndpoint();
+    SimulatedServer *receiver = network.addEndpoint();
+
+    // Nothing arrives before the latency has elapsed
+    sender->sendMessageToAll(query("a.local."));
+    network.advance(40);
+    QCOMPARE(receiver->messagesReceived(), 0);
+    network.advance(10);
+    QCOMPARE(receiver->messagesReceived(), 1);
+    QCOMPARE(sender->messagesReceived(), 0);
+
+    // Unicast messages only reach their destination
+    SimulatedServer *other = network.addEndpoint();
+    QMdnsEngine::Message message = query("b.local.");
+    message.setAddress(receiver->address());
+    message.setPort(QMdnsEngine::MdnsPort);
+    sender->sendMessage(message);
+    network.advance(50);
+    QCOMPARE(receiver->messagesReceived(), 2);
+    QCOMPARE(other->messagesReceived(), 0);
+
+    SimulatedNetwork::Statistics statistics = network.statistics();
+    QCOMPARE(statistics.packetsSent, static_cast<quint64>(2));
+    QCOMPARE(statistics.packetsDelivered, static_cast<quint64>(2));
+}
+
+void TestSimulatedNetwork::testLinkEffects()
+{
+    SimulatedNetwork network;
+    SimulatedServer *sender = network.addEndpoint();
+    SimulatedServer *lossy = network.addEndpoint();
+    SimulatedServer *narrow = network.addEndpoint();
+    network.setLink(sender, lossy, {0, 0, 1, 0, 1500});
+    network.setLink(sender, narrow, {0, 0, 0, 0, 100});
+
+    // Loss drops every packet on the link; the MTU drops those too large
+    sender->sendMessageToAll(query("short.local."));
+    sender->sendMessageToAll(query(QByteArray(60, 'x') + ".local."));
+    network.advance(0);
+    QCOMPARE(lossy->messagesReceived(), 0);
+    QCOMPARE(narrow->messagesReceived(), 1);
+
+    SimulatedNetwork::Statistics statistics = network.statistics();
+    QCOMPARE(statistics.packetsLost, static_cast<quint64>(2));
+    QCOMPARE(statistics.packetsTooLarge, static_cast<quint64>(1));
+
+    // The same packets sent with the same seed are reordered the same way
+    auto arrivalOrder = [this](quint32 seed) {
+        SimulatedNetwork reordered(seed);
+        reordered.setDefaultLink({10, 5, 0, 0.5, 1500});
+        SimulatedServer *from = reordered.addEndpoint();
+        SimulatedServer *to = reordered.addEndpoint();
+        QList<QByteArray> order;
+        to->addMessageListener([&order](const QMdnsEngine::Message &message) {
+            order.append(message.queries().front().name());
+        });
+        for (int i = 0; i < 20; ++i) {
+            from->sendMessageToAll(query(QByteArray::number(i) + ".local."));
+        }
+        reordered.advance(50);
+        return order;
+    };
+    QList<QByteArray> order = arrivalOrder(42);
+    QCOMPARE(order.length(), 20);
+    QCOMPARE(arrivalOrder(42), order);
+}
+
+void TestSimulatedNetwork::testScale()
+{
+    // The defaults keep the test quick; larger runs are configured through
+    // the environment, e.g. 10000 providers and 100 browsers
+    int providerCount = envValue("QMDNSENGINE_SIM_PROVIDERS", 20);
+    int browserCount = envValue("QMDNSENGINE_SIM_BROWSERS", 5);
+    int timeout = envValue("QMDNSENGINE_SIM_TIMEOUT", 30000);
+
+    SimulatedNetwork network;
+    network.setDefaultLink({5, 5, 0.01, 0.01, 1500});
+
+    // Browsers start first and then wait for the providers to announce
+    std::vector<std::unique_ptr<QMdnsEngine::Browser>> browsers;
+    std::vector<QSet<QByteArray>> discovered(browserCount);
+    for (int i = 0; i < browserCount; ++i) {
+        browsers.emplace_back(new QMdnsEngine::Browser(network.addEndpoint(), Type));
+        QSet<QByteArray> *names = &discovered[i];
+        browsers.back()->on<QMdnsEngine::ServiceAdded>([names](const QMdnsEngine::ServiceAdded &event, const QMdnsEngine::Browser&) {
+            names->insert(event.service.name());
+        });
+    }
+
+    std::vector<std::unique_ptr<QMdnsEngine::Hostname>> hostnames;
+    std::vector<std::unique_ptr<QMdnsEngine::Provider>> providers;
+    for (int i = 0; i < providerCount; ++i) {
+        SimulatedServer *server = network.addEndpoint();
+        hostnames.emplace_back(new QMdnsEngine::Hostname(server));
+        providers.emplace_back(new QMdnsEngine::Provider(server, hostnames.back().get()));
+        QMdnsEngine::Service service;
+        service.setType(Type);
+        service.setName("Service " + QByteArray::number(i));
+        service.setPort(1234);
+        providers.back()->update(service);
+    }
+
+    qint64 start = network.now();
+    bool converged = network.advanceUntil([&] {
+        for (const QSet<QByteArray> &names : discovered) {
+            if (names.size() < providerCount) {
+                return false;
+            }
+        }
+        return true;
+    }, timeout);
+
+    SimulatedNetwork::Statistics statistics = network.statistics();
+    qInfo("%d providers, %d browsers: converged=%d in %lld ms, %llu packets (%llu bytes) sent, %llu delivered, %llu lost",
+          providerCount, browserCount, converged, network.now() - start,
+          statistics.packetsSent, statistics.bytesSent,
+          statistics.packetsDelivered, statistics.packetsLost);
+    QVERIFY(converged);
+    QCOMPARE(statistics.packetsTooLarge, static_cast<quint64>(0));
+
+    // Components must go before the network that their servers belong to
+    providers.clear();
+    hostnames.clear();
+    browsers.clear();
+}
+
+QMdnsEngine::Message TestSimulatedNetwork::query(const QByteArray &name)
+{
+    QMdnsEngine::Query query;
+    query.setName(name);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    return message;
+}
+
+int TestSimulatedNetwork::envValue(const char *name, int defaultValue)
+{
+    bool ok;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+QTEST_MAIN(TestSimulatedNetwork)
+#include "TestSimulatedNetwork.moc"
@@ -0,0 +1,182 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTcpSocket>
+#include <QTest>
+
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/prometheusexporter.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/statistics.h>
+
+#include "common/testserver.h"
+
+const QByteArray Name = "test.local.";
+
+class TestStatistics : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testParseErrors_data();
+    void testParseErrors();
+    void testServer();
+    void testCache();
+    void testPrometheus();
+    void testExporter();
+
+private:
+
+    QMdnsEngine::Record createRecord();
+};
+
+void TestStatistics::testParseErrors_data()
+{
+    QTest::addColumn<QByteArray>("packet");
+    QTest::addColumn<int>("error");
+
+    // Header claiming a question, an answer, an authority record or an
+    // additional record in turn, none of which are present
+    QTest::newRow("header") << QByteArray(6, '\0') << static_cast<int>(QMdnsEngine::TruncatedHeader);
+    QTest::newRow("query") << QByteArray("\0\0\0\0\0\1\0\0\0\0\0\0", 12) << static_cast<int>(QMdnsEngine::InvalidQuery);
+    QTest::newRow("answer") << QByteArray("\0\0\0\0\0\0\0\1\0\0\0\0", 12) << static_cast<int>(QMdnsEngine::InvalidAnswer);
+    QTest::newRow("authority") << QByteArray("\0\0\0\0\0\0\0\0\0\1\0\0", 12) << static_cast<int>(QMdnsEngine::InvalidAuthority);
+    QTest::newRow("additional") << QByteArray("\0\0\0\0\0\0\0\0\0\0\0\1", 12) << static_cast<int>(QMdnsEngine::InvalidAdditional);
+    QTest::newRow("valid") << QByteArray(12, '\0') << static_cast<int>(QMdnsEngine::NoParseError);
+}
+
+void TestStatistics::testParseErrors()
+{
+    QFETCH(QByteArray, packet);
+    QFETCH(int, error);
+
+    QMdnsEngine::ParseError parseError;
+    auto message = QMdnsEngine::fromPacket(packet, QHostAddress::LocalHost, QMdnsEngine::MdnsPort, parseError);
+    QCOMPARE(static_cast<bool>(message), error == QMdnsEngine::NoParseError);
+    QCOMPARE(static_cast<int>(parseError), error);
+}
+
+void TestStatistics::testServer()
+{
+    TestServer server;
+    int id = server.addMessageListener([](const QMdnsEngine::Message &) {});
+
+    QMdnsEngine::Message query;
+    server.deliverMessage(query);
+    QMdnsEngine::Message response;
+    response.setResponse(true);
+    server.deliverMessage(response);
+    server.deliverMessage(response);
+    server.removeMessageListener(id);
+    server.deliverMessage(response);
+
+    QMdnsEngine::ServerStatistics statistics = server.statistics();
+    QCOMPARE(statistics.queriesReceived, static_cast<quint64>(1));
+    QCOMPARE(statistics.responsesReceived, static_cast<quint64>(3));
+    QCOMPARE(statistics.messageEvents, static_cast<quint64>(4));
+    QCOMPARE(statistics.listenerCalls, static_cast<quint64>(3));
+}
+
+void TestStatistics::testCache()
+{
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Record record = createRecord();
+    cache.addRecord(record);
+    cache.addRecord(record);
+
+    QMdnsEngine::Record found;
+    QVERIFY(cache.lookupRecord(Name, QMdnsEngine::A, found));
+    QVERIFY(!cache.lookupRecord(Name, QMdnsEngine::AAAA, found));
+
+    record.setTtl(0);
+    cache.addRecord(record);
+
+    QMdnsEngine::CacheStatistics statistics = cache.statistics();
+    QCOMPARE(statistics.size, static_cast<quint64>(0));
+    QCOMPARE(statistics.insertions, static_cast<quint64>(2));
+    QCOMPARE(statistics.hits, static_cast<quint64>(1));
+    QCOMPARE(statistics.misses, static_cast<quint64>(1));
+    QCOMPARE(statistics.expirations, static_cast<quint64>(1));
+}
+
+void TestStatistics::testPrometheus()
+{
+    TestServer server;
+    QMdnsEngine::Cache cache;
+    cache.addRecord(createRecord());
+    server.deliverMessage(QMdnsEngine::Message());
+
+    QMdnsEngine::StatisticsSnapshot snapshot = QMdnsEngine::StatisticsSnapshot::take(&server, &cache);
+    QCOMPARE(snapshot.server.queriesReceived, static_cast<quint64>(1));
+    QCOMPARE(snapshot.cache.size, static_cast<quint64>(1));
+
+    QByteArray text = snapshot.toPrometheus();
+    QVERIFY(text.contains("# TYPE qmdnsengine_messages_received_total counter\n"));
+    QVERIFY(text.contains("qmdnsengine_messages_received_total{kind=\"query\"} 1\n"));
+    QVERIFY(text.contains("qmdnsengine_cache_records 1\n"));
+
+    // Rates are derived from two snapshots
+    QMdnsEngine::StatisticsSnapshot later = snapshot;
+    later.timestamp += 2000;
+    later.server.queriesReceived += 10;
+    QCOMPARE(later.queryRate(snapshot), 5.0);
+}
+
+void TestStatistics::testExporter()
+{
+    TestServer server;
+    QMdnsEngine::PrometheusExporter exporter(&server);
+    QVERIFY(exporter.listen());
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, exporter.port());
+    QVERIFY(socket.waitForConnected());
+    socket.write("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    // The exporter closes the connection once the response is written
+    QTRY_COMPARE(socket.state(), QAbstractSocket::UnconnectedState);
+    QByteArray response = socket.readAll();
+    QVERIFY(response.startsWith("HTTP/1.0 200 OK\r\n"));
+    QVERIFY(response.contains("qmdnsengine_listener_calls_total 0\n"));
+}
+
+QMdnsEngine::Record TestStatistics::createRecord()
+{
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setTtl(3600);
+    record.setAddress(QHostAddress("127.0.0.1"));
+    return record;
+}
+
+QTEST_MAIN(TestStatistics)
+#include "TestStatistics.moc"
@@ -0,0 +1,121 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/tracing.h>
+
+class TestTracing : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testHistogram();
+    void testMerge();
+    void testTracer();
+};
+
+void TestTracing::testHistogram()
+{
+    QMdnsEngine::LatencyHistogram histogram;
+    QCOMPARE(histogram.count(), static_cast<quint64>(0));
+    QCOMPARE(histogram.percentile(50), static_cast<qint64>(0));
+
+    for (qint64 value = 1; value <= 1000; ++value) {
+        histogram.record(value * 1000);
+    }
+    QCOMPARE(histogram.count(), static_cast<quint64>(1000));
+    QCOMPARE(histogram.min(), static_cast<qint64>(1000));
+    QCOMPARE(histogram.max(), static_cast<qint64>(1000000));
+    QCOMPARE(histogram.mean(), 500500.0);
+
+    // Percentiles never underestimate and stay within the bucket precision
+    qint64 p50 = histogram.percentile(50);
+    QVERIFY(p50 >= 500000 && p50 <= 500000 * 17 / 16);
+    qint64 p99 = histogram.percentile(99);
+    QVERIFY(p99 >= 990000 && p99 <= 1000000);
+    QCOMPARE(histogram.percentile(100), static_cast<qint64>(1000000));
+
+    // Small values are exact
+    QMdnsEngine::LatencyHistogram small;
+    small.record(3);
+    small.record(7);
+    QCOMPARE(small.percentile(50), static_cast<qint64>(3));
+    QCOMPARE(small.percentile(100), static_cast<qint64>(7));
+}
+
+void TestTracing::testMerge()
+{
+    QMdnsEngine::LatencyHistogram first;
+    QMdnsEngine::LatencyHistogram second;
+    first.record(10);
+    second.record(20);
+    second.record(30);
+    first.merge(second);
+    QCOMPARE(first.count(), static_cast<quint64>(3));
+    QCOMPARE(first.min(), static_cast<qint64>(10));
+    QCOMPARE(first.max(), static_cast<qint64>(30));
+
+    first.reset();
+    QCOMPARE(first.count(), static_cast<quint64>(0));
+}
+
+void TestTracing::testTracer()
+{
+    QTemporaryDir dir;
+    QString filename = dir.filePath("trace.json");
+
+    QMdnsEngine::Tracer::reset();
+    QVERIFY(QMdnsEngine::Tracer::startChromeTrace(filename));
+    QByteArray packet;
+    QMdnsEngine::toPacket(QMdnsEngine::Message(), packet);
+    QVERIFY(QMdnsEngine::fromPacket(packet, QHostAddress::LocalHost, QMdnsEngine::MdnsPort).has_value());
+    QMdnsEngine::Tracer::stopChromeTrace();
+
+    // Without the hooks, nothing is measured but the trace is still valid
+    quint64 expected = QMdnsEngine::Tracer::isEnabled() ? 1 : 0;
+    QCOMPARE(QMdnsEngine::Tracer::histogram(QMdnsEngine::TraceEncode).count(), expected);
+    QCOMPARE(QMdnsEngine::Tracer::histogram(QMdnsEngine::TraceDecode).count(), expected);
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(document.object().value("traceEvents").toArray().size(), static_cast<int>(expected * 2));
+}
+
+QTEST_MAIN(TestTracing)
+#include "TestTracing.moc"
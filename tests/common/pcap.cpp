@@ -0,0 +1,389 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QFile>
+#include <QtEndian>
+
+#include <qmdnsengine/mdns.h>
+
+#include "pcap.h"
+
+namespace
+{
+
+// Block types used by pcapng
+const quint32 SectionHeaderBlock = 0x0a0d0d0a;
+const quint32 InterfaceDescriptionBlock = 1;
+const quint32 SimplePacketBlock = 3;
+const quint32 EnhancedPacketBlock = 6;
+
+// Link types (as assigned by tcpdump.org)
+const quint32 LinkTypeNull = 0;
+const quint32 LinkTypeEthernet = 1;
+const quint32 LinkTypeRaw = 101;
+const quint32 LinkTypeLinuxSll = 113;
+const quint32 LinkTypeIpv4 = 228;
+const quint32 LinkTypeIpv6 = 229;
+const quint32 LinkTypeLinuxSll2 = 276;
+
+const quint16 EtherTypeIpv4 = 0x0800;
+const quint16 EtherTypeIpv6 = 0x86dd;
+
+struct Interface
+{
+    quint32 linkType;
+    quint32 snapLength;
+    qint64 unitsPerSecond;
+};
+
+const uchar *at(const QByteArray &data, int offset)
+{
+    return reinterpret_cast<const uchar*>(data.constData() + offset);
+}
+
+quint16 read16(const QByteArray &data, int offset, bool bigEndian = true)
+{
+    return bigEndian ? qFromBigEndian<quint16>(at(data, offset)) :
+                       qFromLittleEndian<quint16>(at(data, offset));
+}
+
+quint32 read32(const QByteArray &data, int offset, bool bigEndian = true)
+{
+    return bigEndian ? qFromBigEndian<quint32>(at(data, offset)) :
+                       qFromLittleEndian<quint32>(at(data, offset));
+}
+
+qint64 toMicroseconds(quint64 timestamp, qint64 unitsPerSecond)
+{
+    if (unitsPerSecond % 1000000 == 0) {
+        return timestamp / (unitsPerSecond / 1000000);
+    }
+    return static_cast<qint64>(static_cast<long double>(timestamp) * 1000000 / unitsPerSecond);
+}
+
+void decodeUdp(const QByteArray &frame, int offset, int end, const QHostAddress &address, qint64 timestamp, QList<PcapDatagram> &datagrams)
+{
+    if (offset + 8 > end) {
+        return;
+    }
+    quint16 sourcePort = read16(frame, offset);
+    quint16 destinationPort = read16(frame, offset + 2);
+    int length = read16(frame, offset + 4);
+    if (length < 8 || (sourcePort != QMdnsEngine::MdnsPort &&
+            destinationPort != QMdnsEngine::MdnsPort)) {
+        return;
+    }
+    PcapDatagram datagram{
+        timestamp,
+        address,
+        sourcePort,
+        frame.mid(offset + 8, qMin(length, end - offset) - 8)
+    };
+    datagrams.append(datagram);
+}
+
+void decodeIp(const QByteArray &frame, int offset, quint16 etherType, qint64 timestamp, QList<PcapDatagram> &datagrams)
+{
+    if (offset >= frame.length()) {
+        return;
+    }
+
+    // Raw link types carry no protocol field; use the IP version instead
+    if (!etherType) {
+        switch (static_cast<quint8>(frame.at(offset)) >> 4) {
+        case 4:
+            etherType = EtherTypeIpv4;
+            break;
+        case 6:
+            etherType = EtherTypeIpv6;
+            break;
+        default:
+            return;
+        }
+    }
+
+    switch (etherType) {
+    case EtherTypeIpv4:
+    {
+        if (offset + 20 > frame.length()) {
+            return;
+        }
+        int headerLength = (frame.at(offset) & 0x0f) * 4;
+        int end = qMin(frame.length(), offset + read16(frame, offset + 2));
+        quint16 fragment = read16(frame, offset + 6);
+        if (headerLength < 20 || (fragment & 0x3fff) || frame.at(offset + 9) != 17) {
+            return;  // fragments and protocols other than UDP are skipped
+        }
+        QHostAddress address(read32(frame, offset + 12));
+        decodeUdp(frame, offset + headerLength, end, address, timestamp, datagrams);
+        break;
+    }
+    case EtherTypeIpv6:
+    {
+        if (offset + 40 > frame.length()) {
+            return;
+        }
+        int end = qMin(frame.length(), offset + 40 + read16(frame, offset + 4));
+        quint8 nextHeader = frame.at(offset + 6);
+        QHostAddress address(at(frame, offset + 8));
+
+        // Skip hop-by-hop, routing and destination options headers
+        int position = offset + 40;
+        while (nextHeader == 0 || nextHeader == 43 || nextHeader == 60) {
+            if (position + 2 > end) {
+                return;
+            }
+            nextHeader = frame.at(position);
+            position += (static_cast<quint8>(frame.at(position + 1)) + 1) * 8;
+        }
+        if (nextHeader != 17) {
+            return;
+        }
+        decodeUdp(frame, position, end, address, timestamp, datagrams);
+        break;
+    }
+    }
+}
+
+void decodeFrame(quint32 linkType, const QByteArray &frame, qint64 timestamp, QList<PcapDatagram> &datagrams)
+{
+    int offset = 0;
+    quint16 etherType = 0;
+
+    switch (linkType) {
+    case LinkTypeEthernet:
+        if (frame.length() < 14) {
+            return;
+        }
+        etherType = read16(frame, 12);
+        offset = 14;
+
+        // Skip VLAN tags
+        while (etherType == 0x8100 || etherType == 0x88a8) {
+            if (frame.length() < offset + 4) {
+                return;
+            }
+            etherType = read16(frame, offset + 2);
+            offset += 4;
+        }
+        break;
+    case LinkTypeNull:
+        offset = 4;
+        break;
+    case LinkTypeRaw:
+    case LinkTypeIpv4:
+    case LinkTypeIpv6:
+        break;
+    case LinkTypeLinuxSll:
+        if (frame.length() < 16) {
+            return;
+        }
+        etherType = read16(frame, 14);
+        offset = 16;
+        break;
+    case LinkTypeLinuxSll2:
+        if (frame.length() < 20) {
+            return;
+        }
+        etherType = read16(frame, 0);
+        offset = 20;
+        break;
+    default:
+        return;
+    }
+
+    decodeIp(frame, offset, etherType, timestamp, datagrams);
+}
+
+bool parsePcap(const QByteArray &data, QList<PcapDatagram> &datagrams, QString &error)
+{
+    if (data.length() < 24) {
+        error = "capture is too short";
+        return false;
+    }
+
+    // The magic number determines both byte order and timestamp resolution
+    bool bigEndian;
+    bool nanoseconds;
+    quint32 magic = read32(data, 0, false);
+    if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+        bigEndian = false;
+    } else {
+        magic = read32(data, 0, true);
+        if (magic != 0xa1b2c3d4 && magic != 0xa1b23c4d) {
+            error = "not a pcap or pcapng capture";
+            return false;
+        }
+        bigEndian = true;
+    }
+    nanoseconds = magic == 0xa1b23c4d;
+
+    quint32 linkType = read32(data, 20, bigEndian) & 0x0fffffff;
+    int position = 24;
+    while (position + 16 <= data.length()) {
+        qint64 seconds = read32(data, position, bigEndian);
+        qint64 fraction = read32(data, position + 4, bigEndian);
+        quint32 length = read32(data, position + 8, bigEndian);
+        position += 16;
+        if (position + static_cast<qint64>(length) > data.length()) {
+            break;  // the capture was cut off
+        }
+        qint64 timestamp = seconds * 1000000 + (nanoseconds ? fraction / 1000 : fraction);
+        decodeFrame(linkType, data.mid(position, length), timestamp, datagrams);
+        position += length;
+    }
+    return true;
+}
+
+bool parsePcapng(const QByteArray &data, QList<PcapDatagram> &datagrams, QString &error)
+{
+    bool bigEndian = false;
+    QList<Interface> interfaces;
+    qint64 lastTimestamp = 0;
+
+    int position = 0;
+    while (position + 12 <= data.length()) {
+
+        // Each section header determines the byte order of the blocks
+        // following it (the block type reads the same either way)
+        quint32 type = read32(data, position, bigEndian);
+        if (type == SectionHeaderBlock) {
+            if (read32(data, position + 8, false) == 0x1a2b3c4d) {
+                bigEndian = false;
+            } else if (read32(data, position + 8, true) == 0x1a2b3c4d) {
+                bigEndian = true;
+            } else {
+                error = "invalid pcapng byte-order magic";
+                return false;
+            }
+            interfaces.clear();
+        }
+
+        quint32 length = read32(data, position + 4, bigEndian);
+        if (length < 12 || length % 4 || position + static_cast<qint64>(length) > data.length()) {
+            if (type == SectionHeaderBlock && !position) {
+                error = "invalid pcapng section header";
+                return false;
+            }
+            break;  // the capture was cut off
+        }
+        int body = position + 8;
+        int bodyLength = length - 12;
+
+        switch (type) {
+        case InterfaceDescriptionBlock:
+        {
+            if (bodyLength < 8) {
+                break;
+            }
+            Interface iface{read16(data, body, bigEndian), read32(data, body + 4, bigEndian), 1000000};
+
+            // Look for the timestamp resolution option
+            int option = body + 8;
+            while (option + 4 <= body + bodyLength) {
+                quint16 code = read16(data, option, bigEndian);
+                quint16 optionLength = read16(data, option + 2, bigEndian);
+                if (!code) {
+                    break;
+                }
+                if (code == 9 && optionLength >= 1 && option + 5 <= body + bodyLength) {
+                    quint8 resolution = data.at(option + 4);
+                    bool binary = resolution & 0x80;
+                    int exponent = resolution & 0x7f;
+
+                    // Anything finer than nanoseconds (or 2^-62 seconds)
+                    // does not fit in the units per second
+                    if (exponent > (binary ? 62 : 9)) {
+                        error = "unsupported pcapng timestamp resolution";
+                        return false;
+                    }
+                    qint64 units = 1;
+                    for (int i = 0; i < exponent; ++i) {
+                        units *= binary ? 2 : 10;
+                    }
+                    iface.unitsPerSecond = units;
+                }
+                option += 4 + ((optionLength + 3) & ~3);
+            }
+            interfaces.append(iface);
+            break;
+        }
+        case EnhancedPacketBlock:
+        {
+            if (bodyLength < 20) {
+                break;
+            }
+            quint32 id = read32(data, body, bigEndian);
+            quint64 timestamp = (static_cast<quint64>(read32(data, body + 4, bigEndian)) << 32) |
+                    read32(data, body + 8, bigEndian);
+            int capturedLength = read32(data, body + 12, bigEndian);
+            if (id >= static_cast<quint32>(interfaces.length()) ||
+                    capturedLength < 0 || capturedLength > bodyLength - 20) {
+                break;
+            }
+            const Interface &iface = interfaces.at(id);
+            lastTimestamp = toMicroseconds(timestamp, iface.unitsPerSecond);
+            decodeFrame(iface.linkType, data.mid(body + 20, capturedLength), lastTimestamp, datagrams);
+            break;
+        }
+        case SimplePacketBlock:
+        {
+            // Simple packets carry no timestamp, so the previous one is used
+            if (bodyLength < 4 || interfaces.isEmpty()) {
+                break;
+            }
+            const Interface &iface = interfaces.at(0);
+            int capturedLength = qMin<quint32>(read32(data, body, bigEndian), bodyLength - 4);
+            if (iface.snapLength) {
+                capturedLength = qMin<quint32>(capturedLength, iface.snapLength);
+            }
+            decodeFrame(iface.linkType, data.mid(body + 4, capturedLength), lastTimestamp, datagrams);
+            break;
+        }
+        }
+
+        position += length;
+    }
+    return true;
+}
+
+}
+
+bool parseCapture(const QByteArray &data, QList<PcapDatagram> &datagrams, QString &error)
+{
+    if (data.length() >= 4 && read32(data, 0) == SectionHeaderBlock) {
+        return parsePcapng(data, datagrams, error);
+    }
+    return parsePcap(data, datagrams, error);
+}
+
+bool readCapture(const QString &filename, QList<PcapDatagram> &datagrams, QString &error)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    return parseCapture(file.readAll(), datagrams, error);
+}
@@ -0,0 +1,73 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMON_PCAP_H
+#define COMMON_PCAP_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief UDP datagram extracted from a packet capture
+ */
+struct PcapDatagram
+{
+    /// Capture time in microseconds
+    qint64 timestamp;
+
+    /// Address the datagram was sent from
+    QHostAddress address;
+
+    /// Port the datagram was sent from
+    quint16 port;
+
+    /// UDP payload (the raw DNS message)
+    QByteArray payload;
+};
+
+/**
+ * @brief Extract mDNS datagrams from a pcap or pcapng capture
+ * @param data contents of the capture file
+ * @param datagrams storage for the datagrams (in capture order)
+ * @param error description of the problem if parsing fails
+ * @return true if the capture was parsed
+ *
+ * Only UDP datagrams to or from port 5353 are extracted. Ethernet, Linux
+ * cooked, BSD loopback and raw IP link types are supported; frames that
+ * cannot be decoded (IP fragments, other link types) are skipped.
+ */
+bool parseCapture(const QByteArray &data, QList<PcapDatagram> &datagrams, QString &error);
+
+/**
+ * @brief Read mDNS datagrams from a pcap or pcapng file
+ * @param filename path to the capture file
+ * @param datagrams storage for the datagrams (in capture order)
+ * @param error description of the problem if reading fails
+ * @return true if the file was read and parsed
+ */
+bool readCapture(const QString &filename, QList<PcapDatagram> &datagrams, QString &error);
+
+#endif // COMMON_PCAP_H
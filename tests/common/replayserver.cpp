@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#if defined(Q_OS_UNIX)
+#  include <sys/resource.h>
+#endif
+
+#include <qmdnsengine/dns.h>
+
+#include "replayserver.h"
+
+static qint64 peakMemory()
+{
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#  if defined(Q_OS_MACOS)
+        return usage.ru_maxrss;
+#  else
+        return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#  endif
+    }
+#endif
+    return 0;
+}
+
+double ReplayStats::messagesPerSecond() const
+{
+    return wallTime ? datagrams * 1e9 / wallTime : 0;
+}
+
+double ReplayStats::cpuTimePerMessage() const
+{
+    return datagrams ? static_cast<double>(cpuTime) / datagrams : 0;
+}
+
+qint64 ReplayStats::latencyPercentile(double percentile) const
+{
+    if (latencies.isEmpty()) {
+        return 0;
+    }
+    int index = static_cast<int>(std::ceil(percentile / 100 * latencies.length())) - 1;
+    return latencies.at(qBound(0, index, latencies.length() - 1));
+}
+
+ReplayServer::ReplayServer()
+    : mMessagesSent(0)
+{
+}
+
+void ReplayServer::sendMessage(const QMdnsEngine::Message &)
+{
+    ++mMessagesSent;
+}
+
+void ReplayServer::sendMessageToAll(const QMdnsEngine::Message &)
+{
+    ++mMessagesSent;
+}
+
+ReplayStats ReplayServer::replay(const QList<PcapDatagram> &datagrams, double speed)
+{
+    ReplayStats stats{0, 0, 0, 0, 0, {}, 0};
+    int initialMessagesSent = mMessagesSent;
+    qint64 firstTimestamp = datagrams.isEmpty() ? 0 : datagrams.first().timestamp;
+
+    QElapsedTimer clock;
+    clock.start();
+    std::clock_t initialCpuTime = std::clock();
+
+    for (const PcapDatagram &datagram : datagrams) {
+
+        // Wait until the datagram is due - when running behind, the delay
+        // counts towards its latency
+        qint64 due = clock.nsecsElapsed();
+        if (speed > 0) {
+            due = static_cast<qint64>((datagram.timestamp - firstTimestamp) * 1000 / speed);
+            qint64 wait = (due - clock.nsecsElapsed()) / 1000000;
+            if (wait > 0) {
+                QEventLoop loop;
+                QTimer::singleShot(wait, &loop, &QEventLoop::quit);
+                loop.exec();
+            }
+            due = qMin(due, clock.nsecsElapsed());
+        }
+
+        auto message = QMdnsEngine::fromPacket(datagram.payload, datagram.address, datagram.port);
+        if (message) {
+            dispatchMessage(*message);
+        } else {
+            ++stats.parseErrors;
+        }
+        ++stats.datagrams;
+        stats.latencies.append(clock.nsecsElapsed() - due);
+
+        QCoreApplication::processEvents();
+    }
+
+    stats.wallTime = clock.nsecsElapsed();
+    stats.cpuTime = static_cast<qint64>(
+        static_cast<double>(std::clock() - initialCpuTime) * 1e9 / CLOCKS_PER_SEC);
+    stats.messagesSent = mMessagesSent - initialMessagesSent;
+    stats.peakMemory = peakMemory();
+    std::sort(stats.latencies.begin(), stats.latencies.end());
+    return stats;
+}
@@ -0,0 +1,96 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMON_REPLAYSERVER_H
+#define COMMON_REPLAYSERVER_H
+
+#include <QList>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+#include "pcap.h"
+
+/**
+ * @brief Measurements collected while replaying a capture
+ */
+struct ReplayStats
+{
+    /// Number of datagrams delivered
+    int datagrams;
+
+    /// Number of datagrams that could not be parsed
+    int parseErrors;
+
+    /// Number of messages sent by the components being driven
+    int messagesSent;
+
+    /// Wall-clock time in nanoseconds
+    qint64 wallTime;
+
+    /// Processor time in nanoseconds
+    qint64 cpuTime;
+
+    /// Time from when each datagram was due until it was processed, in nanoseconds (sorted)
+    QList<qint64> latencies;
+
+    /// Peak resident memory of the process in bytes (0 if unavailable)
+    qint64 peakMemory;
+
+    double messagesPerSecond() const;
+    double cpuTimePerMessage() const;
+    qint64 latencyPercentile(double percentile) const;
+};
+
+/**
+ * @brief Server that feeds captured datagrams to the components using it
+ *
+ * Messages sent are counted and discarded, so no network is needed.
+ */
+class ReplayServer : public QMdnsEngine::AbstractServer
+{
+public:
+
+    ReplayServer();
+
+    virtual void sendMessage(const QMdnsEngine::Message &message);
+    virtual void sendMessageToAll(const QMdnsEngine::Message &message);
+
+    /**
+     * @brief Deliver datagrams as if they were received from the network
+     * @param datagrams datagrams to deliver, in order
+     * @param speed playback rate relative to the capture timing (0 delivers
+     *        the datagrams as fast as possible)
+     *
+     * Pending events (such as timers in the components being driven) are
+     * processed between datagrams.
+     */
+    ReplayStats replay(const QList<PcapDatagram> &datagrams, double speed = 0);
+
+private:
+
+    int mMessagesSent;
+};
+
+#endif // COMMON_REPLAYSERVER_H
@@ -0,0 +1,206 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+
+#include "simulatednetwork.h"
+
+// Size of the IPv6 and UDP headers that precede each DNS message
+static const int HeaderSize = 48;
+
+const int SimulatedNetwork::TickInterval = 5;
+
+void SimulatedServer::sendMessage(const QMdnsEngine::Message &message)
+{
+    mNetwork->send(this, message, message.address());
+}
+
+void SimulatedServer::sendMessageToAll(const QMdnsEngine::Message &message)
+{
+    mNetwork->send(this, message, QMdnsEngine::MdnsIpv4Address);
+}
+
+QHostAddress SimulatedServer::address() const
+{
+    return mAddress;
+}
+
+int SimulatedServer::messagesReceived() const
+{
+    return mMessagesReceived;
+}
+
+SimulatedServer::SimulatedServer(SimulatedNetwork *network, const QHostAddress &address)
+    : mNetwork(network),
+      mAddress(address),
+      mMessagesReceived(0)
+{
+}
+
+void SimulatedServer::deliver(const QMdnsEngine::Message &message)
+{
+    ++mMessagesReceived;
+    dispatchMessage(message);
+}
+
+SimulatedNetwork::SimulatedNetwork(quint32 seed)
+    : mDefaultLink{0, 0, 0, 0, 1500},
+      mGenerator(seed),
+      mNow(0),
+      mStatistics{0, 0, 0, 0, 0}
+{
+    mRealTime.start();
+}
+
+SimulatedNetwork::~SimulatedNetwork()
+{
+}
+
+SimulatedServer *SimulatedNetwork::addEndpoint()
+{
+    QHostAddress address(static_cast<quint32>(0x0a000001 + mEndpoints.size()));
+    SimulatedServer *server = new SimulatedServer(this, address);
+    mEndpoints.emplace_back(server);
+    mAddresses.insert(address, server);
+    return server;
+}
+
+void SimulatedNetwork::setDefaultLink(const Link &link)
+{
+    mDefaultLink = link;
+}
+
+void SimulatedNetwork::setLink(SimulatedServer *from, SimulatedServer *to, const Link &link)
+{
+    mLinks.insert(qMakePair(from, to), link);
+}
+
+qint64 SimulatedNetwork::now() const
+{
+    return mNow;
+}
+
+void SimulatedNetwork::advance(qint64 msecs)
+{
+    qint64 target = mNow + msecs;
+    forever {
+        deliverDue();
+        QCoreApplication::processEvents();
+        if (mNow >= target) {
+            break;
+        }
+
+        // Wait for the library's timers to catch up before moving on
+        qint64 next = qMin(target, mNow + TickInterval);
+        qint64 ahead = next - mRealTime.elapsed();
+        if (ahead > 0) {
+            QEventLoop loop;
+            QTimer::singleShot(ahead, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        mNow = next;
+    }
+}
+
+SimulatedNetwork::Statistics SimulatedNetwork::statistics() const
+{
+    return mStatistics;
+}
+
+void SimulatedNetwork::send(SimulatedServer *sender, const QMdnsEngine::Message &message, const QHostAddress &destination)
+{
+    // Serialize the message as it would be sent and parse it again, which
+    // is what every recipient would see
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+    ++mStatistics.packetsSent;
+    mStatistics.bytesSent += packet.length();
+    auto parsed = QMdnsEngine::fromPacket(packet, sender->address(), QMdnsEngine::MdnsPort);
+    if (!parsed) {
+        return;
+    }
+    std::shared_ptr<QMdnsEngine::Message> received = std::make_shared<QMdnsEngine::Message>(*parsed);
+
+    auto schedule = [&](SimulatedServer *receiver) {
+        Link receiverLink = link(sender, receiver);
+        if (receiverLink.mtu && packet.length() + HeaderSize > receiverLink.mtu) {
+            ++mStatistics.packetsTooLarge;
+            return;
+        }
+        if (receiverLink.loss > 0 && random() < receiverLink.loss) {
+            ++mStatistics.packetsLost;
+            return;
+        }
+        qint64 delay = receiverLink.latency;
+        if (receiverLink.jitter > 0) {
+            delay += std::uniform_int_distribution<int>(0, receiverLink.jitter)(mGenerator);
+        }
+        if (receiverLink.reorder > 0 && random() < receiverLink.reorder) {
+            delay += receiverLink.latency + receiverLink.jitter + 1;
+        }
+        mPending.emplace(mNow + delay, Delivery{receiver, received});
+    };
+
+    if (destination.isMulticast()) {
+        for (const auto &endpoint : mEndpoints) {
+            if (endpoint.get() != sender) {
+                schedule(endpoint.get());
+            }
+        }
+    } else {
+        SimulatedServer *receiver = mAddresses.value(destination);
+        if (receiver) {
+            schedule(receiver);
+        } else {
+            ++mStatistics.packetsLost;
+        }
+    }
+}
+
+void SimulatedNetwork::deliverDue()
+{
+    // Deliveries may cause more packets to be sent, which are picked up
+    // right away if they are due
+    while (!mPending.empty() && mPending.begin()->first <= mNow) {
+        Delivery delivery = mPending.begin()->second;
+        mPending.erase(mPending.begin());
+        ++mStatistics.packetsDelivered;
+        delivery.receiver->deliver(*delivery.message);
+    }
+}
+
+SimulatedNetwork::Link SimulatedNetwork::link(SimulatedServer *from, SimulatedServer *to) const
+{
+    return mLinks.value(qMakePair(from, to), mDefaultLink);
+}
+
+double SimulatedNetwork::random()
+{
+    return std::uniform_real_distribution<double>(0, 1)(mGenerator);
+}
@@ -0,0 +1,196 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMON_SIMULATEDNETWORK_H
+#define COMMON_SIMULATEDNETWORK_H
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QPair>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+class SimulatedNetwork;
+
+/**
+ * @brief Endpoint attached to a simulated network
+ */
+class SimulatedServer : public QMdnsEngine::AbstractServer
+{
+public:
+
+    virtual void sendMessage(const QMdnsEngine::Message &message);
+    virtual void sendMessageToAll(const QMdnsEngine::Message &message);
+
+    QHostAddress address() const;
+
+    /// Number of messages received by this endpoint
+    int messagesReceived() const;
+
+private:
+
+    friend class SimulatedNetwork;
+
+    SimulatedServer(SimulatedNetwork *network, const QHostAddress &address);
+
+    void deliver(const QMdnsEngine::Message &message);
+
+    SimulatedNetwork *mNetwork;
+    QHostAddress mAddress;
+    int mMessagesReceived;
+};
+
+/**
+ * @brief Multicast network connecting many endpoints in one process
+ *
+ * Each packet sent is serialized, checked against the MTU of the link and
+ * delivered to its recipients after the link latency, unless it is lost.
+ * Link effects are drawn from a seeded generator, so the same packets sent
+ * in the same order are lost, delayed and reordered the same way.
+ *
+ * Delivery is scheduled on the network's clock, which only moves when
+ * advance() is called and never runs ahead of real time. The library
+ * schedules its own work (queries, cache triggers and random delays) with
+ * Qt timers on real time, so scenarios take as long as the time they
+ * cover and the packets sent differ from one run to the next.
+ */
+class SimulatedNetwork
+{
+public:
+
+    /**
+     * @brief Characteristics of the link between two endpoints
+     */
+    struct Link
+    {
+        /// Delay before a packet is delivered in milliseconds
+        int latency;
+
+        /// Additional random delay of up to this many milliseconds
+        int jitter;
+
+        /// Probability that a packet is lost
+        double loss;
+
+        /// Probability that a packet is delayed past the ones sent after it
+        double reorder;
+
+        /// Largest IP packet that can be sent, 0 for no limit
+        int mtu;
+    };
+
+    /**
+     * @brief Counters for the traffic on the network
+     */
+    struct Statistics
+    {
+        quint64 packetsSent;
+        quint64 bytesSent;
+        quint64 packetsDelivered;
+        quint64 packetsLost;
+        quint64 packetsTooLarge;
+    };
+
+    explicit SimulatedNetwork(quint32 seed = 1);
+    ~SimulatedNetwork();
+
+    /**
+     * @brief Create a new endpoint (owned by the network)
+     */
+    SimulatedServer *addEndpoint();
+
+    void setDefaultLink(const Link &link);
+    void setLink(SimulatedServer *from, SimulatedServer *to, const Link &link);
+
+    /**
+     * @brief Current time on the network's clock in milliseconds
+     */
+    qint64 now() const;
+
+    /**
+     * @brief Move the clock forward, delivering packets that are due
+     *
+     * This waits for real time to catch up so that the library's timers
+     * fire along the way.
+     */
+    void advance(qint64 msecs);
+
+    /**
+     * @brief Advance the clock until the condition is met or the time is up
+     * @return true if the condition was met
+     */
+    template<class Condition>
+    bool advanceUntil(Condition condition, qint64 timeout) {
+        qint64 end = mNow + timeout;
+        while (!condition()) {
+            if (mNow >= end) {
+                return false;
+            }
+            advance(qMin<qint64>(TickInterval, end - mNow));
+        }
+        return true;
+    }
+
+    Statistics statistics() const;
+
+    static const int TickInterval;
+
+private:
+
+    friend class SimulatedServer;
+
+    struct Delivery
+    {
+        SimulatedServer *receiver;
+        std::shared_ptr<QMdnsEngine::Message> message;
+    };
+
+    void send(SimulatedServer *sender, const QMdnsEngine::Message &message, const QHostAddress &destination);
+    void deliverDue();
+    Link link(SimulatedServer *from, SimulatedServer *to) const;
+    double random();
+
+    std::vector<std::unique_ptr<SimulatedServer>> mEndpoints;
+    QHash<QHostAddress, SimulatedServer*> mAddresses;
+    Link mDefaultLink;
+    QHash<QPair<SimulatedServer*, SimulatedServer*>, Link> mLinks;
+
+    std::mt19937 mGenerator;
+    qint64 mNow;
+    QElapsedTimer mRealTime;
+
+    // Deliveries ordered by time and then by the order they were sent
+    std::multimap<qint64, Delivery> mPending;
+
+    Statistics mStatistics;
+};
+
+#endif // COMMON_SIMULATEDNETWORK_H
@@ -46,7 +46,7 @@ void TestServer::sendMessageToAll(const QMdnsEngine::Message &message)
 
 void TestServer::deliverMessage(const QMdnsEngine::Message &message)
 {
-    emit messageReceived(message);
+    dispatchMessage(message);
 }
 
 QList<QMdnsEngine::Message> TestServer::receivedMessages() const
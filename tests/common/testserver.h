@@ -36,8 +36,6 @@
  */
 class TestServer : public QMdnsEngine::AbstractServer
 {
-    Q_OBJECT
-
 public:
 
     virtual void sendMessage(const QMdnsEngine::Message &message);
@@ -0,0 +1,140 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <memory>
+#include <vector>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/hostname.h>
+#include <qmdnsengine/provider.h>
+#include <qmdnsengine/service.h>
+#include <qmdnsengine/tracing.h>
+
+#include "common/pcap.h"
+#include "common/replayserver.h"
+
+/*
+ * Replays the mDNS traffic in a pcap or pcapng capture through browsers
+ * and providers and reports how quickly it was processed
+ */
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay captured mDNS traffic through QMdnsEngine");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "pcap or pcapng file to replay");
+    QCommandLineOption speedOption("speed", "Playback rate relative to the capture (0 = as fast as possible)", "factor", "0");
+    QCommandLineOption browseOption("browse", "Browse for services of the given type", "type");
+    QCommandLineOption provideOption("provide", "Provide a service of the given type", "type");
+    QCommandLineOption repeatOption("repeat", "Number of times to replay the capture", "count", "1");
+    QCommandLineOption traceOption("trace", "Write Chrome trace events to a file (requires tracing hooks)", "file");
+    parser.addOption(speedOption);
+    parser.addOption(browseOption);
+    parser.addOption(provideOption);
+    parser.addOption(repeatOption);
+    parser.addOption(traceOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.positionalArguments().length() != 1) {
+        parser.showHelp(1);
+    }
+
+    QList<PcapDatagram> datagrams;
+    QString error;
+    if (!readCapture(parser.positionalArguments().at(0), datagrams, error)) {
+        err << "unable to read capture: " << error << "\n";
+        return 1;
+    }
+
+    ReplayServer server;
+
+    // Browse for all service types if nothing else was requested
+    QStringList browseTypes = parser.values(browseOption);
+    if (browseTypes.isEmpty() && parser.values(provideOption).isEmpty()) {
+        browseTypes.append("_services._dns-sd._udp.local.");
+    }
+    std::vector<std::unique_ptr<QMdnsEngine::Browser>> browsers;
+    for (const QString &type : browseTypes) {
+        browsers.emplace_back(new QMdnsEngine::Browser(&server, type.toUtf8()));
+    }
+
+    QMdnsEngine::Hostname hostname(&server);
+    std::vector<std::unique_ptr<QMdnsEngine::Provider>> providers;
+    for (const QString &type : parser.values(provideOption)) {
+        QMdnsEngine::Service service;
+        service.setType(type.toUtf8());
+        service.setName("Replay " + QByteArray::number(static_cast<int>(providers.size())));
+        service.setPort(1234);
+        providers.emplace_back(new QMdnsEngine::Provider(&server, &hostname));
+        providers.back()->update(service);
+    }
+
+    if (parser.isSet(traceOption)) {
+        if (!QMdnsEngine::Tracer::isEnabled()) {
+            err << "the library was built without tracing hooks\n";
+        } else if (!QMdnsEngine::Tracer::startChromeTrace(parser.value(traceOption))) {
+            err << "unable to write " << parser.value(traceOption) << "\n";
+            return 1;
+        }
+    }
+
+    double speed = parser.value(speedOption).toDouble();
+    int repeat = qMax(1, parser.value(repeatOption).toInt());
+    for (int i = 0; i < repeat; ++i) {
+        ReplayStats stats = server.replay(datagrams, speed);
+        out << "run " << (i + 1) << ": " << stats.datagrams << " datagrams ("
+            << stats.parseErrors << " unparsable), " << stats.messagesSent << " messages sent\n"
+            << "  throughput:  " << qRound64(stats.messagesPerSecond()) << " messages/s\n"
+            << "  cpu time:    " << qRound64(stats.cpuTimePerMessage()) << " ns/message\n"
+            << "  latency p50: " << stats.latencyPercentile(50) << " ns\n"
+            << "  latency p90: " << stats.latencyPercentile(90) << " ns\n"
+            << "  latency p99: " << stats.latencyPercentile(99) << " ns\n"
+            << "  latency max: " << stats.latencyPercentile(100) << " ns\n"
+            << "  peak memory: " << stats.peakMemory / 1024 << " KiB\n";
+        out.flush();
+    }
+
+    // Break the time down by trace point when the hooks are available
+    if (QMdnsEngine::Tracer::isEnabled()) {
+        for (int i = 0; i < QMdnsEngine::TracePointCount; ++i) {
+            QMdnsEngine::TracePoint point = static_cast<QMdnsEngine::TracePoint>(i);
+            QMdnsEngine::LatencyHistogram histogram = QMdnsEngine::Tracer::histogram(point);
+            out << QMdnsEngine::Tracer::name(point) << ": " << histogram.count() << " samples, p50 "
+                << histogram.percentile(50) << " ns, p99 " << histogram.percentile(99)
+                << " ns, max " << histogram.max() << " ns\n";
+        }
+        QMdnsEngine::Tracer::stopChromeTrace();
+    }
+
+    return 0;
+}